@@ -0,0 +1,242 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <iostream>
+#include <iomanip> // setw
+#include <string>
+#include <exception>
+#include <vector>
+#include <algorithm> // max
+#include <cstring> // strlen
+#include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp> // hardware_concurrency
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/exception.hpp>
+
+#include "bench.h"
+#include "file.h"
+#include "parse_error.h"
+#include "compressed_file.h"
+#include "ligand_archive.h"
+
+void write_file(const path& name, const std::string& contents) {
+	ofile out(name);
+	out << contents;
+}
+
+sz num_regressions = 0;
+
+void regression(const std::string& kind, const std::string& what) {
+	std::cout << "REGRESSION (" << kind << "): " << what << '\n';
+	++num_regressions;
+}
+
+void write_result(const bench_settings& settings, const std::string& benchmark, const std::string& measurement, fl ops, const std::string& unit, fl seconds) {
+	if(!settings.results) return;
+	std::ostream& out = *settings.results;
+	out << "{\"benchmark\": \"" << benchmark << "\", \"measurement\": \"" << measurement << "\", \"unit\": \"" << unit << "\", "
+	    << std::setprecision(9) << "\"ops\": " << ops << ", \"seconds\": " << seconds << ", "
+	    << "\"ns_per_op\": " << (ops > 0 ? 1e9 * seconds / ops : 0) << ", \"ops_per_second\": " << (seconds > 0 ? ops / seconds : 0) << "}\n";
+}
+
+struct benchmark {
+	const char* name;
+	void (*run)(const bench_settings& settings);
+	const char* description;
+};
+
+const benchmark benchmarks[] = {
+	{ "parse", parse_bench, "PDBQT parsing throughput of a large receptor and a ligand library, and loading the same library precompiled" },
+	{ "startup", startup_bench, "receptor setup (parsing, bond perception, typing) at protein density, cropped to a search box, and loading its snapshot" },
+	{ "kernels", kernels_bench, "the inner kernels of the search and the setup, one at a time, in ns per op" },
+	{ "docking", docking_bench, "seeded end-to-end docking of a panel of complexes, optionally checked against a baseline for docking quality, an unchanged search, and speed if the baseline has times (src/bench/docking_baseline.txt has none)" },
+	{ "coarse_grids", coarse_grids_bench, "seeded docking of the panel with and without coarse maps for the hunting phase of the Monte Carlo search, for the time saved and the docking quality kept" },
+	{ "sparse_grids", sparse_grids_bench, "seeded docking of the panel in a box for blind docking, with the maps computed in full or in bricks as the search reaches them" },
+	{ "grid_storage", grid_storage_bench, "the maps in float and in int16 against double: the errors of the energies at the local minima that the search reaches, the memory, and seeded docking of the panel" },
+	{ "huge_pages", huge_pages_bench, "grid::evaluate and precalculate::eval_fast at random points of large tables, in ordinary, transparent huge and reserved huge pages" },
+	{ "session", session_bench, "docking through receptor_session, the interface for other programs, against main_procedure, and scoring a pose it returns" },
+	{ "scaling", scaling_bench, "the search and the refinement of one ligand on 1 to --threads threads, at a fixed amount of work" },
+	{ "instrument", instrument_bench, "a Monte Carlo search with the inner-loop instrumentation off and on (see vina --instrument)" }
+};
+const sz num_benchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+int main(int argc, char* argv[]) {
+	using namespace boost::program_options;
+	const std::string version_string = "AutoDock Vina Benchmarks 1.1.2 (May 11, 2011)";
+
+	try {
+		bench_settings settings;
+		std::vector<std::string> names;
+		std::string dir_name, receptor_name, ligand_name, results_name, baseline_name, write_baseline_name;
+		bool help = false, version = false;
+		options_description inputs("Benchmark sizes (optional)");
+		inputs.add_options()
+			("receptor_atoms", value<sz>(&settings.receptor_atoms)->default_value(100000), "atoms in the synthetic receptor")
+			("ligands", value<sz>(&settings.ligands)->default_value(2000), "ligands in the synthetic library")
+			("repeats", value<sz>(&settings.repeats)->default_value(5), "how many times each measurement is repeated")
+			("threads", value<sz>(&settings.threads), "the most threads the scaling benchmark uses, and those of rmsd_lower_bound_matrix in the kernels one (the number of hardware threads by default)")
+			("dir", value<std::string>(&dir_name), "directory for the generated inputs (a fresh temporary directory, removed afterwards, by default)")
+			("receptor", value<std::string>(&receptor_name), "a real rigid part of the receptor (PDBQT) to dock into, instead of the synthetic one, with ligand")
+			("ligand", value<std::string>(&ligand_name), "a real ligand (PDBQT), with receptor")
+		;
+		options_description outputs("Output (optional)");
+		outputs.add_options()
+			("results", value<std::string>(&results_name), "also write the results here, one JSON object per line")
+		;
+		options_description gates("Regression gates (optional)");
+		gates.add_options()
+			("baseline", value<std::string>(&baseline_name), "check the docking or instrument benchmark against this baseline")
+			("write_baseline", value<std::string>(&write_baseline_name), "write the docking or instrument results here, as a new baseline")
+			("time_tolerance", value<fl>(&settings.time_tolerance)->default_value(0.1), "allowed slowdown against a baseline with times, written on the same machine (0.1 is 10%)")
+			("energy_tolerance", value<fl>(&settings.energy_tolerance)->default_value(0.5), "allowed rise of the best energy against the baseline (kcal/mol)")
+		;
+		options_description info("Information (optional)");
+		info.add_options()
+			("help", bool_switch(&help), "print this message")
+			("version", bool_switch(&version), "print program version")
+		;
+		options_description hidden;
+		hidden.add_options()
+			("benchmark", value<std::vector<std::string> >(&names), "")
+		;
+		options_description desc, desc_all;
+		desc.add(inputs).add(outputs).add(gates).add(info);
+		desc_all.add(desc).add(hidden);
+
+		positional_options_description positional;
+		positional.add("benchmark", -1);
+		variables_map vm;
+		try {
+			store(command_line_parser(argc, argv)
+				.options(desc_all)
+				.style(command_line_style::default_style ^ command_line_style::allow_guessing)
+				.positional(positional)
+				.run(), 
+				vm);
+			notify(vm); 
+		}
+		catch(boost::program_options::error& e) {
+			std::cerr << "Command line parse error: " << e.what() << '\n' << "\nCorrect usage:\n" << desc << '\n';
+			return 1;
+		}
+		if(help) {
+			std::cout << "Usage: vina_bench [options] [benchmark ...]\n\nBenchmarks (all of them by default):\n";
+			sz width = 0;
+			VINA_FOR(i, num_benchmarks)
+				width = (std::max)(width, std::strlen(benchmarks[i].name));
+			VINA_FOR(i, num_benchmarks)
+				std::cout << "  " << std::setw(width + 2) << std::left << benchmarks[i].name << benchmarks[i].description << '\n';
+			std::cout << desc << '\n';
+			return 0;
+		}
+		if(version) {
+			std::cout << version_string << '\n';
+			return 0;
+		}
+		if(settings.repeats < 1) {
+			std::cerr << "repeats must be at least 1\n";
+			return 1;
+		}
+		if(vm.count("threads") == 0)
+			settings.threads = (std::max)(boost::thread::hardware_concurrency(), 1u);
+		if(settings.threads < 1) {
+			std::cerr << "threads must be at least 1\n";
+			return 1;
+		}
+		if(receptor_name.empty() != ligand_name.empty()) {
+			std::cerr << "receptor and ligand go together\n";
+			return 1;
+		}
+		settings.receptor = path(receptor_name);
+		settings.ligand = path(ligand_name);
+		boost::scoped_ptr<ofile> results;
+		if(!results_name.empty())
+			results.reset(new ofile(path(results_name)));
+		settings.results = results.get();
+		settings.baseline = path(baseline_name);
+		settings.write_baseline = path(write_baseline_name);
+
+		std::vector<const benchmark*> selected;
+		VINA_FOR_IN(i, names) {
+			sz j = 0;
+			for(; j < num_benchmarks; ++j)
+				if(names[i] == benchmarks[j].name) break;
+			if(j == num_benchmarks) {
+				std::cerr << "Unknown benchmark \"" << names[i] << "\"\n";
+				return 1;
+			}
+			selected.push_back(&benchmarks[j]);
+		}
+		if(selected.empty())
+			VINA_FOR(j, num_benchmarks)
+				selected.push_back(&benchmarks[j]);
+
+		const bool temporary = dir_name.empty();
+		settings.dir = temporary ? boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("vina_bench_%%%%%%%%") : path(dir_name);
+		boost::filesystem::create_directories(settings.dir);
+
+		VINA_FOR_IN(i, selected) {
+			std::cout << "== " << selected[i]->name << " ==\n";
+			selected[i]->run(settings);
+		}
+
+		if(temporary)
+			boost::filesystem::remove_all(settings.dir);
+		if(num_regressions > 0) {
+			std::cout << num_regressions << " regression(s)\n";
+			return 2;
+		}
+	}
+	catch(file_error& e) {
+		std::cerr << "\n\nError: could not open \"" << e.name.string() << "\" for " << (e.in ? "reading" : "writing") << ".\n";
+		return 1;
+	}
+	catch(boost::filesystem::filesystem_error& e) {
+		std::cerr << "\n\nFile system error: " << e.what() << '\n';
+		return 1;
+	}
+	catch(parse_error& e) {
+		std::cerr << "\n\nParse error on line " << e.line << " in file \"" << e.file.string() << "\": " << e.reason << '\n';
+		return 1;
+	}
+	catch(compression_error& e) {
+		std::cerr << "\n\nError reading or writing \"" << e.name.string() << "\": " << e.reason << ".\n";
+		return 1;
+	}
+	catch(archive_error& e) {
+		std::cerr << "\n\nError reading \"" << e.name.string() << "\": " << e.reason << ".\n";
+		return 1;
+	}
+	catch(std::bad_alloc&) {
+		std::cerr << "\n\nError: insufficient memory!\n";
+		return 1;
+	}
+	catch(internal_error& e) {
+		std::cerr << "\n\nAn internal error occurred in " << e.file << "(" << e.line << ").\n";
+		return 1;
+	}
+	catch(std::exception& e) { 
+		std::cerr << "\n\nAn error occurred: " << e.what() << ".\n";
+		return 1;
+	}
+}
@@ -0,0 +1,65 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_BENCH_H
+#define VINA_BENCH_H
+
+#include <iosfwd>
+#include <string>
+#include "common.h"
+#include "timers.h" // wall_timer
+
+struct bench_settings {
+	sz receptor_atoms;
+	sz ligands;
+	sz repeats;
+	sz threads; // the most that the scaling benchmark uses; also those for bonding the receptors
+	path dir; // scratch space for the generated inputs
+	path receptor; // real inputs for the benchmarks that dock, instead of the synthetic ones, if not empty
+	path ligand;
+	std::ostream* results; // machine-readable results, if not NULL
+	path baseline;       // to check the docking or instrument benchmark against, if not empty
+	path write_baseline; // where the docking or instrument benchmark records a new one, if not empty
+	fl time_tolerance;   // allowed slowdown against the baseline, as a fraction
+	fl energy_tolerance; // allowed rise of the best energy against the baseline, kcal/mol
+};
+
+void write_file(const path& name, const std::string& contents); // can throw file_error
+
+// one JSON Lines record to settings.results, if any: ops of the given unit done in the given time
+void write_result(const bench_settings& settings, const std::string& benchmark, const std::string& measurement, fl ops, const std::string& unit, fl seconds);
+
+void regression(const std::string& kind, const std::string& what); // reported at once, and vina_bench then exits with status 2
+
+void parse_bench(const bench_settings& settings);
+void startup_bench(const bench_settings& settings);
+void instrument_bench(const bench_settings& settings);
+void kernels_bench(const bench_settings& settings);
+void docking_bench(const bench_settings& settings);
+void scaling_bench(const bench_settings& settings);
+void huge_pages_bench(const bench_settings& settings);
+void coarse_grids_bench(const bench_settings& settings);
+void sparse_grids_bench(const bench_settings& settings);
+void grid_storage_bench(const bench_settings& settings);
+void session_bench(const bench_settings& settings);
+
+#endif
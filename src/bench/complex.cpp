@@ -0,0 +1,73 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include "complex.h"
+#include "synthetic.h"
+#include "parse_pdbqt.h"
+#include "current_weights.h"
+#include "mapped_file.h"
+
+namespace {
+	std::string contents(const path& name) { // can throw file_error
+		mapped_file f(name);
+		return std::string(f.data(), f.end());
+	}
+
+	std::string receptor_text(const bench_settings& settings, sz receptor_atoms) {
+		if(!settings.receptor.empty())
+			return contents(settings.receptor);
+		rng generator(1);
+		return synthetic_receptor(receptor_atoms, generator);
+	}
+
+	std::string ligand_text(const bench_settings& settings, sz torsions) {
+		if(!settings.ligand.empty())
+			return contents(settings.ligand);
+		return synthetic_ligand(torsions);
+	}
+
+	model complex_model(const bench_settings& settings, const std::string& receptor, const std::string& ligand) {
+		const path receptor_name = settings.receptor.empty() ? path("receptor") : settings.receptor; // for the error messages
+		const path ligand_name   = settings.ligand.empty()   ? path("ligand")   : settings.ligand;
+		model tmp = parse_receptor_pdbqt(receptor_name, receptor.data(), receptor.data() + receptor.size(), settings.threads);
+		tmp.append(parse_ligand_pdbqt(ligand_name, ligand.data(), ligand.data() + ligand.size()));
+		return tmp;
+	}
+
+	grid_dims complex_box(const bench_settings& settings, const model& m) {
+		if(!settings.receptor.empty())
+			return m.movable_atoms_box(8);
+		const fl granularity = 0.375;
+		const fl half_size = 6;
+		grid_dims tmp;
+		VINA_FOR_IN(i, tmp) {
+			tmp[i].n = sz(2 * half_size / granularity);
+			tmp[i].begin = -half_size;
+			tmp[i].end = half_size;
+		}
+		return tmp;
+	}
+}
+
+bench_complex::bench_complex(const bench_settings& settings, sz receptor_atoms, sz torsions)
+	: receptor_pdbqt(receptor_text(settings, receptor_atoms)), ligand_pdbqt(ligand_text(settings, torsions)), m(complex_model(settings, receptor_pdbqt, ligand_pdbqt)), wt(&t, current_weights(t)), prec(wt), gd(complex_box(settings, m)),
+	  corner1(gd[0].begin, gd[1].begin, gd[2].begin), corner2(gd[0].end, gd[1].end, gd[2].end), real(!settings.receptor.empty()) {}
@@ -0,0 +1,50 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_BENCH_COMPLEX_H
+#define VINA_BENCH_COMPLEX_H
+
+#include <string>
+#include <boost/utility.hpp> // noncopyable
+#include "bench.h"
+#include "model.h"
+#include "everything.h"
+#include "weighted_terms.h"
+
+// a receptor and a ligand, with the scoring function set up over a search space, as vina does it:
+// the synthetic ones, in a 12 A box at the pocket, or the real ones named in the settings,
+// in a box 8 A larger than the ligand
+struct bench_complex : private boost::noncopyable {
+	std::string receptor_pdbqt; // what m was parsed from
+	std::string ligand_pdbqt;
+	model m;
+	everything t;
+	weighted_terms wt;
+	precalculate prec;
+	grid_dims gd;
+	vec corner1;
+	vec corner2;
+	bool real;
+	bench_complex(const bench_settings& settings, sz receptor_atoms, sz torsions); // the sizes of the synthetic ones
+};
+
+#endif
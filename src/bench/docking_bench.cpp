@@ -0,0 +1,377 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <cmath> // ceil
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <map>
+#include "bench.h"
+#include "complex.h"
+#include "docking.h"
+#include "current_weights.h"
+#include "quasi_newton.h"
+#include "file.h"
+
+namespace {
+	struct docking_case {
+		const char* name;
+		sz receptor_atoms;
+		sz torsions;
+	};
+
+	const docking_case docking_cases[] = { // of the synthetic panel
+		{ "small",  1500, 1 },
+		{ "medium", 3000, 3 },
+		{ "large",  6000, 5 }
+	};
+	const sz num_docking_cases = sizeof(docking_cases) / sizeof(docking_cases[0]);
+
+	std::vector<docking_case> panel_cases(const bench_settings& settings) { // the synthetic panel, or the real complex of the settings
+		std::vector<docking_case> tmp;
+		if(settings.receptor.empty())
+			tmp.assign(docking_cases, docking_cases + num_docking_cases);
+		else {
+			docking_case real = { "real", 0, 0 };
+			tmp.push_back(real);
+		}
+		return tmp;
+	}
+
+	const int docking_exhaustiveness = 2;
+	const int docking_seed = 1;
+
+	struct docking_result {
+		fl seconds; // the best of the repeats
+		fl evals;
+		fl best_energy;
+		fl grid_seconds; // of the last repeat
+		fl grid_mb;      // what the maps came to
+		docking_result() : seconds(0), evals(0), best_energy(max_fl), grid_seconds(0), grid_mb(0) {}
+	};
+
+	typedef std::map<std::string, docking_result> docking_results;
+
+	void check_quality(const std::string& name, const docking_result& r, const docking_result& reference, const std::string& reference_name, const bench_settings& settings) {
+		if(r.best_energy > reference.best_energy + settings.energy_tolerance) {
+			std::ostringstream what;
+			what << std::fixed << std::setprecision(3) << name << ": best energy " << r.best_energy << " against " << reference.best_energy << " kcal/mol " << reference_name;
+			regression("docking quality", what.str());
+		}
+	}
+
+	const fl grid_spacing = 0.375;  // of the maps, as in main
+	const fl coarse_spacing = 0.75; // of the coarse maps compared with them
+	const fl blind_box = 60; // the edge of the search space for blind docking, A
+
+	fl grid_points(const grid_dims& gd, fl spacing) { // per atom type, as cache::set_coarse sizes the maps
+		fl tmp = 1;
+		VINA_FOR_IN(i, gd)
+			tmp *= std::ceil(gd[i].span() / spacing) + 1;
+		return tmp;
+	}
+
+	struct docking_variant { // of the maps, and of the search space
+		grid_options grids;
+		fl box; // if not 0, the edge of a search space with the same center, instead of the complex's
+		docking_variant() : box(0) {}
+	};
+
+	docking_result dock(const bench_complex& x, sz repeats, const docking_variant& v = docking_variant()) { // with the default settings of vina, on one thread
+		docking_result tmp;
+		const flv weights = current_weights(x.t); // vina's
+		grid_dims gd = x.gd;
+		if(v.box > 0)
+			gd = search_space(0.5 * (x.corner1 + x.corner2), vec(v.box, v.box, v.box), grid_spacing);
+		VINA_FOR(r, repeats) {
+			std::ostringstream out, discard;
+			tee log;
+			log.console = &discard;
+			job_report report;
+			wall_timer t;
+			scoring_setup setup(weights, gd, v.grids);
+			model m = x.m;
+			main_procedure(m, boost::optional<model>(), setup, &out,
+						   false, false, false, false, false, // a full search, with the cache
+						   gd, docking_exhaustiveness, weights,
+						   1, docking_seed, 0, 9, 3, log, report);
+			const fl seconds = t.elapsed();
+			if(r == 0 || seconds < tmp.seconds)
+				tmp.seconds = seconds;
+			tmp.evals = fl(report.stats.counters.evals);
+			tmp.best_energy = report.best_energy;
+			tmp.grid_seconds = report.grid.wall;
+			if(v.grids.sparse)
+				tmp.grid_mb = fl(setup.sparse->bricks_computed()) * brick_array3d::brick_points * sizeof(fl) / 1048576;
+			else
+				tmp.grid_mb = fl(setup.c.bytes()) / 1048576;
+		}
+		return tmp;
+	}
+
+	docking_results read_baseline(const path& name) { // can throw file_error
+		docking_results tmp;
+		ifile in(name);
+		std::string line;
+		while(std::getline(in, line)) {
+			std::istringstream fields(line);
+			std::string case_name;
+			docking_result r;
+			if(!(fields >> case_name) || case_name[0] == '#') continue;
+			if(fields >> r.evals >> r.best_energy) {
+				if(!(fields >> r.seconds))
+					r.seconds = 0; // no times, as in the one in the source tree
+				tmp[case_name] = r;
+			}
+		}
+		return tmp;
+	}
+
+	void write_baseline(const path& name, const docking_results& results) { // can throw file_error
+		ofile out(name);
+		out << "# vina_bench docking baseline: case, evaluations, best energy (kcal/mol), and optionally seconds (best of the repeats)\n"
+		    << "# the times are only comparable on the machine and build that wrote this file, and are only checked if present\n";
+		out << std::setprecision(9);
+		for(docking_results::const_iterator i = results.begin(); i != results.end(); ++i)
+			out << i->first << ' ' << i->second.evals << ' ' << i->second.best_energy << ' ' << i->second.seconds << '\n';
+	}
+
+	void compare(const bench_settings& settings, const std::string& name, const docking_result& r, const docking_result& base) {
+		if(base.seconds > 0 && r.seconds > base.seconds * (1 + settings.time_tolerance)) {
+			std::ostringstream what;
+			what << std::fixed << std::setprecision(3) << name << ": " << r.seconds << " s against " << base.seconds << " s in the baseline";
+			regression("speed", what.str());
+		}
+		check_quality(name, r, base, "in the baseline", settings);
+		if(r.evals != base.evals) { // the seeded search is deterministic, so this is a change of the search itself
+			std::ostringstream what;
+			what << std::setprecision(9) << name << ": " << r.evals << " evaluations against " << base.evals << " in the baseline";
+			regression("determinism", what.str());
+		}
+	}
+
+	void print(const std::string& name, const docking_result& r) {
+		std::cout << std::setw(14) << std::left << name << std::right
+		          << std::fixed << std::setprecision(3) << std::setw(9) << r.seconds << " s "
+		          << std::setprecision(0) << std::setw(10) << r.evals << " evaluations "
+		          << std::setprecision(3) << std::setw(9) << r.best_energy << " kcal/mol\n";
+		std::cout.unsetf(std::ios::floatfield);
+	}
+}
+
+void docking_bench(const bench_settings& settings) {
+	const std::vector<docking_case> cases = panel_cases(settings);
+	std::cout << "exhaustiveness " << docking_exhaustiveness << ", seed " << docking_seed << ", 1 thread, best of " << settings.repeats << '\n';
+
+	docking_results results;
+	VINA_FOR_IN(i, cases) {
+		const bench_complex x(settings, cases[i].receptor_atoms, cases[i].torsions);
+		const docking_result r = dock(x, settings.repeats);
+		results[cases[i].name] = r;
+		std::cout << std::setw(8) << std::left << cases[i].name << std::right
+		          << std::setw(6) << x.m.num_movable_atoms() << " movable atoms "
+		          << std::fixed << std::setprecision(3) << std::setw(9) << r.seconds << " s "
+		          << std::setprecision(0) << std::setw(10) << r.evals << " evaluations "
+		          << std::setw(8) << 3600 / r.seconds << " ligands/hour "
+		          << std::setprecision(3) << std::setw(9) << r.best_energy << " kcal/mol\n";
+		std::cout.unsetf(std::ios::floatfield);
+		write_result(settings, "docking", cases[i].name, 1, "ligand", r.seconds);
+	}
+
+	if(!settings.baseline.empty()) {
+		const docking_results base = read_baseline(settings.baseline);
+		for(docking_results::const_iterator i = results.begin(); i != results.end(); ++i) {
+			docking_results::const_iterator j = base.find(i->first);
+			if(j == base.end())
+				std::cout << "  " << i->first << ": not in the baseline\n";
+			else
+				compare(settings, i->first, i->second, j->second);
+		}
+	}
+	if(!settings.write_baseline.empty())
+		write_baseline(settings.write_baseline, results);
+}
+
+void coarse_grids_bench(const bench_settings& settings) {
+	const std::vector<docking_case> cases = panel_cases(settings);
+	std::cout << "exhaustiveness " << docking_exhaustiveness << ", seed " << docking_seed << ", 1 thread, best of " << settings.repeats
+	          << "; the first local optimization of each Monte Carlo step on the " << grid_spacing << " A maps or on " << coarse_spacing << " A ones\n";
+
+	VINA_FOR_IN(i, cases) {
+		const bench_complex x(settings, cases[i].receptor_atoms, cases[i].torsions);
+		const std::string name = cases[i].name;
+		const docking_result fine   = dock(x, settings.repeats);
+		docking_variant v;
+		v.grids.coarse = coarse_spacing;
+		const docking_result coarse = dock(x, settings.repeats, v);
+		print(name + " fine", fine);
+		print(name + " coarse", coarse);
+		std::cout << "  speedup " << std::fixed << std::setprecision(2) << fine.seconds / coarse.seconds
+		          << ", hunting maps " << std::setprecision(1) << grid_points(x.gd, grid_spacing) / grid_points(x.gd, coarse_spacing) << " times smaller"
+		          << ", best energy " << std::showpos << std::setprecision(3) << coarse.best_energy - fine.best_energy << std::noshowpos << " kcal/mol\n";
+		std::cout.unsetf(std::ios::floatfield);
+		write_result(settings, "coarse_grids", name + "_fine",   1, "ligand", fine.seconds);
+		write_result(settings, "coarse_grids", name + "_coarse", 1, "ligand", coarse.seconds);
+		check_quality(name + " coarse", coarse, fine, "fine", settings);
+	}
+}
+
+void sparse_grids_bench(const bench_settings& settings) {
+	const std::vector<docking_case> cases = panel_cases(settings);
+	std::cout << "exhaustiveness " << docking_exhaustiveness << ", seed " << docking_seed << ", 1 thread, best of " << settings.repeats
+	          << "; a " << blind_box << " A box, with the maps computed in full or in bricks as the search reaches them\n";
+
+	VINA_FOR_IN(i, cases) {
+		const bench_complex x(settings, cases[i].receptor_atoms, cases[i].torsions);
+		const std::string name = cases[i].name;
+		docking_variant v;
+		v.box = blind_box;
+		const docking_result full = dock(x, settings.repeats, v);
+		v.grids.sparse = true;
+		const docking_result sparse = dock(x, settings.repeats, v);
+		print(name + " full", full);
+		print(name + " sparse", sparse);
+		std::cout << "  speedup " << std::fixed << std::setprecision(2) << full.seconds / sparse.seconds
+		          << ", maps " << std::setprecision(3) << full.grid_seconds << " s and " << std::setprecision(1) << full.grid_mb << " MB in full, "
+		          << std::setprecision(3) << sparse.grid_seconds << " s and " << std::setprecision(1) << sparse.grid_mb << " MB in bricks\n";
+		std::cout.unsetf(std::ios::floatfield);
+		if(sparse.evals != full.evals || sparse.best_energy != full.best_energy)
+			std::cout << "  " << name << ": the search differs with the maps in bricks (" << sparse.evals << " evaluations against " << full.evals << ")\n";
+		write_result(settings, "sparse_grids", name + "_full",   1, "ligand", full.seconds);
+		write_result(settings, "sparse_grids", name + "_sparse", 1, "ligand", sparse.seconds);
+		check_quality(name + " sparse", sparse, full, "in full", settings);
+		if(sparse.grid_mb >= full.grid_mb) {
+			std::ostringstream what;
+			what << std::fixed << std::setprecision(1) << name << ": " << sparse.grid_mb << " MB of bricks against " << full.grid_mb << " MB of maps in full";
+			regression("memory", what.str());
+		}
+	}
+}
+
+namespace {
+	struct storage_case {
+		const char* name;
+		grid_storage storage;
+	};
+
+	const storage_case storage_cases[] = {
+		{ "float", GRID_FLOAT },
+		{ "int16", GRID_QUANTIZED }
+	};
+	const sz num_storage_cases = sizeof(storage_cases) / sizeof(storage_cases[0]);
+
+	struct storage_errors { // of the energies with a storage against those with the double maps, over the validation poses, kcal/mol
+		fl max, rms;
+		sz poses;
+		storage_errors() : max(0), rms(0), poses(0) {}
+		void add(fl de) {
+			max = (std::max)(max, std::abs(de));
+			rms += de * de;
+			++poses;
+		}
+		void finish() {
+			if(poses > 0)
+				rms = std::sqrt(rms / poses);
+		}
+	};
+
+	void print(const std::string& name, const storage_errors& e) {
+		std::cout << "    " << std::setw(10) << std::left << name << std::right << std::setw(6) << e.poses << " poses, error max "
+		          << std::scientific << std::setprecision(2) << e.max << " rms " << e.rms << " kcal/mol\n";
+		std::cout.unsetf(std::ios::floatfield);
+	}
+}
+
+void grid_storage_bench(const bench_settings& settings) {
+	const std::vector<docking_case> cases = panel_cases(settings);
+	const sz num_poses = 2000; // the validation set: local minima reached from random poses in the search space, as the search keeps them
+	const fl v = 1000; // as in the refinement of the search
+	const fl clash = 10; // kcal/mol; the poses below this with the double maps are reported on their own, as those not in a clash, where int16 caps the maps
+	std::cout << "the maps in float and int16 against those in double: the energies of " << num_poses << " local minima of the ligand in the search space, "
+	          << "and in docking (exhaustiveness " << docking_exhaustiveness << ", seed " << docking_seed << ", 1 thread, best of " << settings.repeats << ")\n";
+
+	VINA_FOR_IN(i, cases) {
+		const bench_complex x(settings, cases[i].receptor_atoms, cases[i].torsions);
+		const std::string name = cases[i].name;
+		model m = x.m;
+		const szv atom_types = m.get_movable_atom_types(x.prec.atom_typing_used());
+		cache reference("scoring_function_version001", x.gd, 1e6, atom_type::XS);
+		reference.populate(m, x.prec, atom_types, false);
+		std::cout << name << ": " << m.num_movable_atoms() << " movable atoms, maps of " << std::fixed << std::setprecision(1)
+		          << fl(reference.bytes()) / 1048576 << " MB in double\n";
+		std::cout.unsetf(std::ios::floatfield);
+
+		rng generator(2); // the same poses every time
+		quasi_newton hunt; // as in a Monte Carlo step, with the clashes capped, and then to convergence, on the double maps
+		hunt.max_steps = unsigned((25 + m.num_movable_atoms()) / 3);
+		const quasi_newton converge;
+		const vec hunt_cap(10, 10, 10);
+		const vec authentic_v(v, v, v);
+		change g(m.get_size());
+		std::vector<conf> poses;
+		VINA_FOR(p, num_poses) {
+			output_type pose(m.get_initial_conf(), 0);
+			pose.c.randomize(x.corner1, x.corner2, generator);
+			hunt    (m, x.prec, reference, pose, g, hunt_cap);
+			converge(m, x.prec, reference, pose, g, authentic_v);
+			poses.push_back(pose.c);
+		}
+		flv reference_energies;
+		VINA_FOR_IN(p, poses) {
+			m.set(poses[p]);
+			reference_energies.push_back(reference.eval(m, v));
+		}
+
+		const docking_result full = dock(x, settings.repeats);
+		print("  double", full);
+		VINA_FOR(s, num_storage_cases) {
+			cache c("scoring_function_version001", x.gd, 1e6, atom_type::XS);
+			c.set_storage(storage_cases[s].storage);
+			c.populate(m, x.prec, atom_types, false);
+			storage_errors all, kept;
+			VINA_FOR_IN(p, poses) {
+				m.set(poses[p]);
+				const fl de = c.eval(m, v) - reference_energies[p];
+				all.add(de);
+				if(reference_energies[p] < clash)
+					kept.add(de);
+			}
+			all.finish();
+			kept.finish();
+			docking_variant dv;
+			dv.grids.storage = storage_cases[s].storage;
+			const docking_result r = dock(x, settings.repeats, dv);
+			print(std::string("  ") + storage_cases[s].name, r);
+			std::cout << "  maps of " << std::fixed << std::setprecision(1) << fl(c.bytes()) / 1048576 << " MB, "
+			          << std::setprecision(2) << fl(reference.bytes()) / c.bytes() << " times smaller; best energy "
+			          << std::showpos << std::setprecision(3) << r.best_energy - full.best_energy << std::noshowpos << " kcal/mol\n";
+			std::cout.unsetf(std::ios::floatfield);
+			print("all", all);
+			std::ostringstream below;
+			below << "below " << clash;
+			print(below.str(), kept);
+			write_result(settings, "grid_storage", name + "_" + storage_cases[s].name, 1, "ligand", r.seconds);
+			check_quality(name + " " + storage_cases[s].name, r, full, "in double", settings);
+		}
+		write_result(settings, "grid_storage", name + "_double", 1, "ligand", full.seconds);
+	}
+}
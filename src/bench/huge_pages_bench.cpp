@@ -0,0 +1,157 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "bench.h"
+#include "grid.h"
+#include "precalculate.h"
+#include "everything.h"
+#include "weighted_terms.h"
+#include "current_weights.h"
+#include "docking.h" // search_space
+#include "random.h"
+
+// grid::evaluate and precalculate::eval_fast at random points of tables much larger than what the TLB covers with ordinary pages,
+// with the tables allocated in each of the ways of huge_pages.h
+
+namespace {
+	volatile fl sink; // keeps the results of the loops alive
+
+	const fl box_size = 40; // Angstroms, as for a large pocket or a small protein
+	const sz num_grids = 6; // the atom types of a typical ligand
+
+	struct allocation_mode {
+		const char* name;
+		huge_pages_mode mode;
+	};
+
+	const allocation_mode allocation_modes[] = {
+		{ "off",         HUGE_PAGES_OFF },
+		{ "transparent", HUGE_PAGES_TRANSPARENT },
+		{ "reserved",    HUGE_PAGES_RESERVED }
+	};
+	const sz num_allocation_modes = sizeof(allocation_modes) / sizeof(allocation_modes[0]);
+
+	std::string first_line(const char* name) { // of a kernel setting, if there is one
+		std::ifstream in(name);
+		std::string tmp;
+		std::getline(in, tmp);
+		return tmp.empty() ? "unknown" : tmp;
+	}
+
+	std::string anon_huge_pages() { // the memory of this process in transparent huge pages, as the kernel sees it
+		std::ifstream in("/proc/self/smaps_rollup");
+		std::string line;
+		while(std::getline(in, line))
+			if(line.compare(0, 14, "AnonHugePages:") == 0) {
+				std::istringstream fields(line.substr(14));
+				std::string kb;
+				fields >> kb;
+				return kb + " kB";
+			}
+		return "unknown";
+	}
+
+	fl megabytes(sz bytes) { return bytes / (1024.0 * 1024.0); }
+
+	void report(const bench_settings& settings, const std::string& what, const char* mode, fl ops, const std::string& unit, fl seconds) {
+		std::cout << "  " << std::setw(28) << std::left << what << std::right
+		          << std::fixed << std::setprecision(1) << std::setw(10) << 1e9 * seconds / ops << " ns per " << unit << '\n';
+		std::cout.unsetf(std::ios::floatfield);
+		write_result(settings, "huge_pages", what + " (" + mode + ")", ops, unit, seconds);
+	}
+}
+
+void huge_pages_bench(const bench_settings& settings) {
+	const grid_dims gd = search_space(zero_vec, vec(box_size, box_size, box_size));
+	const vec corner1(gd[0].begin, gd[1].begin, gd[2].begin);
+	const vec corner2(gd[0].end,   gd[1].end,   gd[2].end);
+	const sz grid_points = (gd[0].n + 1) * (gd[1].n + 1) * (gd[2].n + 1);
+	std::cout << num_grids << " grids of " << grid_points << " points (" << std::fixed << std::setprecision(1) << megabytes(num_grids * grid_points * sizeof(fl)) << " MB)"
+	          << ", transparent huge pages: " << first_line("/sys/kernel/mm/transparent_hugepage/enabled")
+	          << ", reserved huge pages: " << first_line("/proc/sys/vm/nr_hugepages") << '\n';
+	std::cout.unsetf(std::ios::floatfield);
+
+	everything t;
+	weighted_terms wt(&t, current_weights(t));
+	const sz num_types = num_atom_types(wt.atom_typing_used());
+
+	rng generator(3); // the same points for every mode
+	vecv locations;
+	szv which;
+	flv r2s;
+	szv pairs;
+	VINA_FOR(i, 65536) {
+		locations.push_back(random_in_box(corner1, corner2, generator));
+		which.push_back(random_sz(0, num_grids - 1, generator));
+		r2s.push_back(random_fl(0, sqr(wt.cutoff()) * 0.999, generator));
+		pairs.push_back(random_sz(0, num_types * (num_types + 1) / 2 - 1, generator));
+	}
+
+	VINA_FOR(m, num_allocation_modes) {
+		const allocation_mode& mode = allocation_modes[m];
+		set_huge_pages(mode.mode);
+		std::vector<grid> grids(num_grids);
+		VINA_FOR_IN(i, grids) {
+			grids[i].init(gd);
+			array3d<fl, huge_page_allocator<fl> >& d = grids[i].m_data;
+			VINA_FOR(x, d.dim0())
+				VINA_FOR(y, d.dim1())
+					VINA_FOR(z, d.dim2())
+						d(x, y, z) = random_fl(-1, 1, generator);
+		}
+		const precalculate p(wt);
+		const huge_page_counts counts = huge_pages_allocated();
+		std::cout << mode.name << ": " << std::fixed << std::setprecision(1)
+		          << megabytes(counts.reserved) << " MB in reserved huge pages, " << megabytes(counts.transparent) << " MB advised to be in transparent ones, "
+		          << megabytes(counts.ordinary) << " MB in ordinary pages; AnonHugePages " << anon_huge_pages() << '\n';
+		std::cout.unsetf(std::ios::floatfield);
+		{
+			const sz n = settings.repeats * 1000000;
+			fl e = 0;
+			vec deriv;
+			wall_timer timer;
+			VINA_FOR(i, n) {
+				const sz k = i % locations.size();
+				e += grids[which[k]].evaluate(locations[k], 1e6, 1000, deriv);
+			}
+			report(settings, "grid::evaluate", mode.name, fl(n), "point", timer.elapsed());
+			sink = e;
+		}
+		{
+			const sz n = settings.repeats * 4000000;
+			fl e = 0;
+			wall_timer timer;
+			VINA_FOR(i, n) {
+				const sz k = i % r2s.size();
+				e += p.eval_fast(pairs[k], r2s[k]);
+			}
+			report(settings, "precalculate::eval_fast", mode.name, fl(n), "pair", timer.elapsed());
+			sink = e;
+		}
+	}
+	set_huge_pages(HUGE_PAGES_TRANSPARENT); // vina's default
+}
@@ -0,0 +1,142 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include "bench.h"
+#include "complex.h"
+#include "cache.h"
+#include "monte_carlo.h"
+#include "instrument.h"
+#include "file.h"
+
+namespace {
+	struct search_run { // one single-threaded Monte Carlo search per seed, the same work every time
+		fl seconds;
+		search_counters counters;
+		instrument_counts instrument;
+		search_run() : seconds(0) {}
+	};
+
+	search_run run_searches(const model& m, const precalculate& p, const igrid& ig, const vec& corner1, const vec& corner2, const monte_carlo& mc, sz repeats, bool instrumented) {
+		set_instrumentation(instrumented);
+		search_run tmp;
+		instrument_install install(&tmp.instrument);
+		wall_timer t;
+		VINA_FOR(r, repeats) {
+			model mm = m;
+			output_container out;
+			rng generator(static_cast<rng::result_type>(r + 1));
+			mc(mm, out, p, ig, p, ig, corner1, corner2, NULL, generator, &tmp.counters);
+		}
+		tmp.seconds = t.elapsed();
+		set_instrumentation(false);
+		return tmp;
+	}
+
+	// the disabled run of another build, so that the cost of the hooks themselves can be seen (make instrument_overhead)
+	struct instrument_baseline {
+		fl seconds; // per search
+		unsigned long evals;
+		bool compiled;
+		instrument_baseline() : seconds(0), evals(0), compiled(false) {}
+	};
+
+	instrument_baseline read_baseline(const path& name) { // can throw file_error
+		instrument_baseline tmp;
+		ifile in(name);
+		std::string line;
+		while(std::getline(in, line)) {
+			std::istringstream fields(line);
+			std::string what;
+			if(fields >> what && what == "disabled")
+				fields >> tmp.seconds >> tmp.evals >> tmp.compiled;
+		}
+		return tmp;
+	}
+
+	void write_baseline(const path& name, fl seconds, unsigned long evals) { // can throw file_error
+		ofile out(name);
+		out << "# vina_bench instrument baseline: seconds per search and evaluations with the instrumentation disabled, and whether it was compiled in\n"
+		    << "# the times are only comparable on the machine that wrote this file\n";
+		out << std::setprecision(9) << "disabled " << seconds << ' ' << evals << ' ' << instrumentation_compiled << '\n';
+	}
+
+	void compare(const bench_settings& settings, fl seconds, unsigned long evals, const instrument_baseline& base) {
+		std::cout << "  against the baseline build (instrumentation " << (base.compiled ? "compiled in" : "not compiled in") << "): "
+		          << std::fixed << std::setprecision(3) << base.seconds << " s per search, "
+		          << std::setprecision(1) << 100 * (seconds / base.seconds - 1) << "% overhead\n";
+		std::cout.unsetf(std::ios::floatfield);
+		if(seconds > base.seconds * (1 + settings.time_tolerance)) {
+			std::ostringstream what;
+			what << std::fixed << std::setprecision(3) << "disabled instrumentation: " << seconds << " s per search against " << base.seconds << " s in the baseline";
+			regression("speed", what.str());
+		}
+		if(evals != base.evals)
+			std::cout << "  the search differs from the baseline's (" << evals << " evaluations against " << base.evals << ")\n";
+	}
+}
+
+void instrument_bench(const bench_settings& settings) {
+	bench_complex x(settings, 3000, 6); // a pocket's worth: the search, not the setup, is measured here
+	const model& m = x.m;
+	cache c("scoring_function_version001", x.gd, 1e6, atom_type::XS);
+	c.populate(m, x.prec, m.get_movable_atom_types(x.prec.atom_typing_used()), false);
+
+	monte_carlo mc; // as in vina, but with fewer steps
+	mc.num_steps = 2000;
+	mc.ssd_par.evals = unsigned((25 + m.num_movable_atoms()) / 3);
+	mc.min_rmsd = 1.0;
+	mc.num_saved_mins = 20;
+	mc.hunt_cap = vec(10, 10, 10);
+
+	std::cout << "instrumentation " << (instrumentation_compiled ? "compiled in (-DVINA_INSTRUMENT)" : "not compiled in") << ", "
+	          << settings.repeats << " searches of " << mc.num_steps << " steps, " << m.num_movable_atoms() << " movable atoms\n";
+
+	const search_run off = run_searches(m, x.prec, c, x.corner1, x.corner2, mc, settings.repeats, false);
+	std::cout << std::setw(18) << std::left << "disabled" << std::right
+	          << std::fixed << std::setprecision(3) << std::setw(9) << off.seconds / settings.repeats << " s per search "
+	          << off.counters.evals << " evaluations\n";
+	write_result(settings, "instrument", "search, instrumentation disabled", fl(settings.repeats), "search", off.seconds);
+	if(!settings.baseline.empty())
+		compare(settings, off.seconds / settings.repeats, off.counters.evals, read_baseline(settings.baseline));
+	if(!settings.write_baseline.empty())
+		write_baseline(settings.write_baseline, off.seconds / settings.repeats, off.counters.evals);
+	if(!instrumentation_compiled) {
+		std::cout.unsetf(std::ios::floatfield);
+		return;
+	}
+	const search_run on = run_searches(m, x.prec, c, x.corner1, x.corner2, mc, settings.repeats, true);
+	std::cout << std::setw(18) << std::left << "enabled" << std::right
+	          << std::fixed << std::setprecision(3) << std::setw(9) << on.seconds / settings.repeats << " s per search "
+	          << on.counters.evals << " evaluations, "
+	          << std::setprecision(1) << 100 * (on.seconds / off.seconds - 1) << "% overhead\n";
+	write_result(settings, "instrument", "search, instrumentation enabled", fl(settings.repeats), "search", on.seconds);
+	VINA_FOR(i, INSTRUMENT_POINTS) {
+		const boost::uint64_t calls = on.instrument.calls[i];
+		std::cout << "  " << std::setw(18) << std::left << instrument_point_name(i) << std::right
+		          << std::setw(12) << calls << " calls "
+		          << std::setprecision(0) << std::setw(9) << (calls > 0 ? fl(on.instrument.nanoseconds[i]) / calls : 0) << " ns per call\n";
+	}
+	std::cout.unsetf(std::ios::floatfield);
+}
@@ -0,0 +1,212 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include "bench.h"
+#include "complex.h"
+#include "cache.h"
+#include "non_cache.h"
+#include "quasi_newton.h"
+#include "coords.h" // output_store
+
+namespace {
+	volatile fl sink; // keeps the results of the loops alive
+
+	void report_kernel(const bench_settings& settings, const std::string& what, fl ops, const std::string& unit, fl seconds) {
+		std::cout << std::setw(30) << std::left << what << std::right
+		          << std::fixed << std::setprecision(1) << std::setw(12) << 1e9 * seconds / ops << " ns per " << std::setw(14) << std::left << unit << std::right
+		          << std::scientific << std::setprecision(3) << ops / seconds << " per s\n";
+		std::cout.unsetf(std::ios::floatfield);
+		write_result(settings, "kernels", what, ops, unit, seconds);
+	}
+
+	interacting_pairs movable_pairs(const model& m) { // all pairs of the typed movable atoms, like those within a ligand
+		const atom_type::t atu = m.atom_typing_used();
+		const sz n = num_atom_types(atu);
+		interacting_pairs tmp;
+		VINA_FOR(i, m.num_movable_atoms()) {
+			const sz t1 = m.movable_atom(i).get(atu);
+			if(t1 >= n) continue;
+			VINA_RANGE(j, i + 1, m.num_movable_atoms()) {
+				const sz t2 = m.movable_atom(j).get(atu);
+				if(t2 < n)
+					tmp.push_back(interacting_pair(triangular_matrix_index_permissive(n, t1, t2), i, j));
+			}
+		}
+		return tmp;
+	}
+}
+
+void kernels_bench(const bench_settings& settings) {
+	bench_complex x(settings, 3000, 6);
+	model& m = x.m;
+	const sz repeats = settings.repeats;
+	const sz grid_points = (x.gd[0].n + 1) * (x.gd[1].n + 1) * (x.gd[2].n + 1);
+	const szv atom_types = m.get_movable_atom_types(x.prec.atom_typing_used());
+	std::cout << (x.real ? "real" : "synthetic") << " complex, " << m.num_movable_atoms() << " movable atoms, "
+	          << grid_points << " grid points for each of " << atom_types.size() << " atom types\n";
+
+	rng generator(2); // the same inputs every time
+	std::vector<conf> confs; // in the search space
+	VINA_FOR(i, 64) {
+		conf c = m.get_initial_conf();
+		c.randomize(x.corner1, x.corner2, generator);
+		confs.push_back(c);
+	}
+
+	{
+		wall_timer t;
+		VINA_FOR(r, repeats) {
+			precalculate p(x.wt);
+			sink = p.cutoff_sqr();
+		}
+		report_kernel(settings, "precalculate construction", fl(repeats), "table", t.elapsed());
+	}
+
+	cache c("scoring_function_version001", x.gd, 1e6, atom_type::XS);
+	{
+		wall_timer t;
+		VINA_FOR(r, repeats) {
+			cache tmp("scoring_function_version001", x.gd, 1e6, atom_type::XS);
+			tmp.populate(m, x.prec, atom_types, false);
+		}
+		report_kernel(settings, "cache::populate", fl(repeats * grid_points * atom_types.size()), "grid point", t.elapsed());
+		c.populate(m, x.prec, atom_types, false);
+	}
+	{
+		grid g(x.gd);
+		VINA_FOR(i, g.m_data.dim0())
+			VINA_FOR(j, g.m_data.dim1())
+				VINA_FOR(k, g.m_data.dim2())
+					g.m_data(i, j, k) = random_fl(-1, 1, generator);
+		vecv locations;
+		VINA_FOR(i, 4096)
+			locations.push_back(random_in_box(x.corner1, x.corner2, generator));
+		const sz n = repeats * 1000000;
+		fl e = 0;
+		vec deriv;
+		wall_timer t;
+		VINA_FOR(i, n)
+			e += g.evaluate(locations[i % locations.size()], 1e6, 1000, deriv);
+		report_kernel(settings, "grid::evaluate", fl(n), "point", t.elapsed());
+		sink = e;
+	}
+	{
+		const sz n = repeats * 100000;
+		wall_timer t;
+		VINA_FOR(i, n)
+			m.set(confs[i % confs.size()]);
+		report_kernel(settings, "model::set", fl(n), "conformation", t.elapsed());
+	}
+	{
+		non_cache nc(m, x.gd, &x.prec, 1e6);
+		m.set(confs.front());
+		const sz n = repeats * 2000;
+		fl e = 0;
+		wall_timer t;
+		VINA_FOR(i, n)
+			e += nc.eval_deriv(m, 1000);
+		report_kernel(settings, "non_cache::eval_deriv", fl(n), "evaluation", t.elapsed());
+		sink = e;
+	}
+	{
+		const interacting_pairs pairs = movable_pairs(m);
+		vecv coords;
+		VINA_FOR(i, m.num_movable_atoms())
+			coords.push_back(m.movable_coords(i));
+		vecv forces(coords.size(), zero_vec);
+		const sz n = repeats * 20000;
+		fl e = 0;
+		wall_timer t;
+		VINA_FOR(i, n)
+			e += eval_interacting_pairs_deriv(x.prec, 1000, pairs, coords, forces);
+		report_kernel(settings, "eval_interacting_pairs_deriv", fl(n * pairs.size()), "pair", t.elapsed());
+		sink = e;
+	}
+	{
+		quasi_newton qn; // as in a Monte Carlo step
+		qn.max_steps = unsigned((25 + m.num_movable_atoms()) / 3);
+		const vec hunt_cap(10, 10, 10);
+		change g(m.get_size());
+		search_counters counters;
+		const sz n = repeats * 200;
+		wall_timer t;
+		VINA_FOR(i, n) {
+			output_type out(confs[i % confs.size()], 0);
+			qn(m, x.prec, c, out, g, hunt_cap, &counters);
+		}
+		const fl seconds = t.elapsed();
+		report_kernel(settings, "bfgs", fl(n), "optimization", seconds);
+		report_kernel(settings, "bfgs evaluations", fl(counters.evals), "evaluation", seconds);
+	}
+	{
+		output_container poses; // with coordinates and energies, as the search leaves them
+		VINA_FOR(i, 256) {
+			const conf& cf = confs[i % confs.size()];
+			m.set(cf);
+			poses.push_back(new output_type(cf, random_fl(-10, 0, generator)));
+			poses.back().coords = m.get_heavy_atom_movable_coords();
+		}
+		const sz rounds = repeats * 200;
+		wall_timer t;
+		VINA_FOR(r, rounds) {
+			output_store store(1, 20); // min_rmsd and num_saved_mins of vina's search
+			store.add(poses);
+			sink = fl(store.size());
+		}
+		report_kernel(settings, "output_store::add", fl(rounds * poses.size()), "pose", t.elapsed());
+	}
+	{
+		output_container poses;
+		VINA_FOR_IN(i, confs) {
+			m.set(confs[i]);
+			poses.push_back(new output_type(confs[i], 0));
+			poses.back().coords = m.get_heavy_atom_movable_coords();
+		}
+		const szv elements = m.get_heavy_atom_movable_elements();
+		const sz rounds = repeats * 20;
+		const sz threads = (std::max)(settings.threads, sz(2)); // the parallel path, even on one core
+		triangular_matrix<fl> lb;
+		wall_timer t;
+		VINA_FOR(r, rounds)
+			lb = rmsd_lower_bound_matrix(poses, elements, threads);
+		report_kernel(settings, "rmsd_lower_bound_matrix", fl(rounds * poses.size() * (poses.size() - 1) / 2), "pair", t.elapsed());
+
+		model a = m; // each entry against model::rmsd_lower_bound on the same poses
+		model b = m;
+		VINA_FOR_IN(i, confs) {
+			a.set(confs[i]);
+			VINA_RANGE(j, i+1, confs.size()) {
+				b.set(confs[j]);
+				const fl expected = a.rmsd_lower_bound(b);
+				if(lb(i, j) != expected) {
+					std::ostringstream what;
+					what << "rmsd_lower_bound_matrix on " << threads << " threads: " << lb(i, j) << " for poses " << i << " and " << j
+					     << " against " << expected << " from model::rmsd_lower_bound";
+					regression("correctness", what.str());
+				}
+			}
+		}
+	}
+}
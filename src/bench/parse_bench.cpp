@@ -0,0 +1,96 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <iostream>
+#include <iomanip>
+#include "bench.h"
+#include "synthetic.h"
+#include "mapped_file.h"
+#include "parse_pdbqt.h"
+#include "ligand_archive.h"
+
+namespace {
+	void report_parse(const bench_settings& settings, const std::string& what, sz atoms, sz bytes, fl seconds) {
+		std::cout << std::setw(16) << std::left << what << std::right
+		          << std::setw(10) << atoms << " atoms "
+		          << std::fixed << std::setprecision(3) << std::setw(9) << seconds << " s "
+		          << std::scientific << std::setprecision(3) << fl(atoms) / seconds << " atoms/s "
+		          << std::fixed << std::setprecision(1) << std::setw(8) << fl(bytes) / seconds / 1e6 << " MB/s\n";
+		std::cout.unsetf(std::ios::floatfield);
+		write_result(settings, "parse", what, fl(atoms), "atoms", seconds);
+	}
+}
+
+void parse_bench(const bench_settings& settings) {
+	rng generator(1);
+	const path receptor_name = settings.dir / "receptor.pdbqt";
+	write_file(receptor_name, synthetic_receptor(settings.receptor_atoms, generator));
+
+	std::vector<path> ligand_names;
+	VINA_FOR(i, settings.ligands) {
+		ligand_names.push_back(settings.dir / ("ligand_" + to_string(i) + ".pdbqt"));
+		write_file(ligand_names.back(), synthetic_ligand(2 + i % 11)); // 6 to 26 heavy atoms
+	}
+
+	{
+		sz atoms = 0, bytes = 0;
+		wall_timer t;
+		VINA_FOR(r, settings.repeats) {
+			mapped_file f(receptor_name);
+			atoms += parse_receptor_atoms_pdbqt(receptor_name, f.data(), f.end()).size();
+			bytes += f.size();
+		}
+		report_parse(settings, "receptor", atoms, bytes, t.elapsed());
+	}
+	{
+		sz atoms = 0, bytes = 0;
+		wall_timer t;
+		VINA_FOR(r, settings.repeats)
+			VINA_FOR_IN(i, ligand_names) {
+				mapped_file f(ligand_names[i]);
+				atoms += parse_ligand_pdbqt(ligand_names[i], f.data(), f.end()).num_movable_atoms();
+				bytes += f.size();
+			}
+		report_parse(settings, "ligand library", atoms, bytes, t.elapsed());
+	}
+	{
+		const path archive_name = settings.dir / "ligands.vlib";
+		{
+			ligand_archive_writer w(archive_name);
+			VINA_FOR_IN(i, ligand_names) {
+				mapped_file f(ligand_names[i]);
+				w.add(parse_ligand_pdbqt(ligand_names[i], f.data(), f.end()));
+			}
+			w.finish();
+		}
+		sz atoms = 0, bytes = 0;
+		wall_timer t;
+		VINA_FOR(r, settings.repeats) {
+			mapped_file f(archive_name);
+			ligand_archive_reader archive(archive_name, f.data(), f.end());
+			VINA_FOR(i, archive.size())
+				atoms += archive.get(i).num_movable_atoms();
+			bytes += f.size();
+		}
+		report_parse(settings, "ligand archive", atoms, bytes, t.elapsed());
+	}
+}
@@ -0,0 +1,128 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include "bench.h"
+#include "complex.h"
+#include "cache.h"
+#include "parallel_mc.h"
+#include "docking.h"
+#include "trace.h"
+
+// Grid population (cache::populate) runs on one thread in this tree, so only the search and the refinement are measured here.
+
+namespace {
+	struct scaling_run {
+		sz threads;
+		fl seconds; // wall
+		fl idle;    // summed over the pool threads: waiting in parallel_for for work, including at the end, when others are still busy
+	};
+
+	szv thread_counts(sz most) { // 1, 2, 4, ... and most
+		szv tmp;
+		for(sz n = 1; n < most; n *= 2)
+			tmp.push_back(n);
+		tmp.push_back(most);
+		return tmp;
+	}
+
+	void report_scaling(const bench_settings& settings, const std::string& phase, const std::vector<scaling_run>& runs, sz tasks, const char* unit) {
+		std::cout << phase << ", " << tasks << ' ' << unit << "s:\n"
+		          << "  threads   seconds   speedup   efficiency   idle share\n";
+		VINA_FOR_IN(i, runs) {
+			const scaling_run& r = runs[i];
+			const fl speedup = runs.front().seconds / r.seconds;
+			std::cout << std::setw(9) << r.threads
+			          << std::fixed << std::setprecision(3) << std::setw(10) << r.seconds
+			          << std::setprecision(2) << std::setw(10) << speedup
+			          << std::setprecision(1) << std::setw(12) << 100 * speedup / r.threads << '%'
+			          << std::setw(12) << 100 * r.idle / (r.threads * r.seconds) << "%\n";
+			std::ostringstream measurement;
+			measurement << phase << ", " << r.threads << " threads";
+			write_result(settings, "scaling", measurement.str(), fl(tasks), unit, r.seconds);
+		}
+		std::cout.unsetf(std::ios::floatfield);
+	}
+}
+
+void scaling_bench(const bench_settings& settings) {
+	bench_complex x(settings, 3000, 6);
+	cache c("scoring_function_version001", x.gd, 1e6, atom_type::XS);
+	c.populate(x.m, x.prec, x.m.get_movable_atom_types(x.prec.atom_typing_used()), false);
+	start_tracing(); // for the time the pool threads spend waiting
+
+	const szv counts = thread_counts(settings.threads);
+	parallel_mc par; // as in vina, but with fewer steps
+	par.mc.num_steps = 2000;
+	par.mc.ssd_par.evals = unsigned((25 + x.m.num_movable_atoms()) / 3);
+	par.mc.min_rmsd = 1.0;
+	par.mc.num_saved_mins = 20;
+	par.mc.hunt_cap = vec(10, 10, 10);
+	par.num_tasks = (std::max)(counts.back(), sz(8)); // the same work for every thread count
+	par.display_progress = false;
+
+	output_container poses; // of the search, to be refined
+	std::vector<scaling_run> search_runs, refine_runs;
+	VINA_FOR_IN(i, counts) {
+		scaling_run r = { counts[i], max_fl, 0 };
+		VINA_FOR(k, settings.repeats) { // the best of the repeats
+			par.num_threads = counts[i];
+			output_container out;
+			rng generator(1);
+			discard_trace();
+			wall_timer t;
+			par(x.m, out, x.prec, c, x.prec, c, x.corner1, x.corner2, generator);
+			const fl seconds = t.elapsed();
+			if(seconds < r.seconds) {
+				r.seconds = seconds;
+				r.idle = traced_seconds("idle");
+			}
+			if(poses.empty())
+				poses = out;
+		}
+		search_runs.push_back(r);
+	}
+	report_scaling(settings, "search", search_runs, par.num_tasks, "task");
+
+	non_cache nc(x.m, x.gd, &x.prec, 1e6);
+	const vec authentic_v(1000, 1000, 1000);
+	VINA_FOR_IN(i, counts) {
+		scaling_run r = { counts[i], max_fl, 0 };
+		VINA_FOR(k, settings.repeats) {
+			model m = x.m;
+			output_container out = poses;
+			discard_trace();
+			wall_timer t;
+			refine_structures(m, x.prec, nc, out, authentic_v, par.mc.ssd_par.evals, counts[i]);
+			const fl seconds = t.elapsed();
+			if(seconds < r.seconds) {
+				r.seconds = seconds;
+				r.idle = traced_seconds("idle");
+			}
+		}
+		refine_runs.push_back(r);
+	}
+	report_scaling(settings, "refinement", refine_runs, poses.size(), "pose");
+	stop_tracing(); // so that the benchmarks after this one are not traced
+}
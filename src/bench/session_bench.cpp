@@ -0,0 +1,135 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <cmath> // abs
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include "bench.h"
+#include "complex.h"
+#include "docking.h"
+#include "receptor_session.h"
+#include "current_weights.h"
+
+namespace {
+	const sz session_receptor_atoms = 3000; // the medium complex of the docking panel
+	const sz session_torsions = 3;
+	const int session_exhaustiveness = 2;
+	const int session_seed = 1;
+	const fl score_tolerance = 0.05; // kcal/mol, as the written coordinates are rounded to 0.001 A
+
+	std::string without_model_lines(const std::string& pdbqt) { // of vina's output, to compare with the poses of receptor_session
+		std::istringstream in(pdbqt);
+		std::string tmp, line;
+		while(std::getline(in, line))
+			if(line.compare(0, 5, "MODEL") != 0)
+				tmp += line + '\n';
+		return tmp;
+	}
+
+	std::string joined(const docked_poses& poses) {
+		std::string tmp;
+		VINA_FOR_IN(i, poses)
+			tmp += poses[i].pdbqt + "ENDMDL\n";
+		return tmp;
+	}
+
+	bool same(const docked_poses& a, const docked_poses& b) {
+		if(a.size() != b.size()) return false;
+		VINA_FOR_IN(i, a)
+			if(a[i].energy != b[i].energy || a[i].pdbqt != b[i].pdbqt)
+				return false;
+		return true;
+	}
+}
+
+void session_bench(const bench_settings& settings) {
+	const bench_complex x(settings, session_receptor_atoms, session_torsions);
+	const std::string name = x.real ? "real" : "medium";
+	std::cout << name << ": exhaustiveness " << session_exhaustiveness << ", seed " << session_seed << ", 1 thread; "
+	          << "vina's main_procedure against receptor_session, docking the ligand a first time and again with its maps kept (best of " << settings.repeats << ")\n";
+
+	const flv weights = current_weights(x.t);
+	std::ostringstream out, discard;
+	tee log;
+	log.console = &discard;
+	job_report report;
+	wall_timer main_time;
+	{
+		scoring_setup setup(weights, x.gd);
+		model m = x.m;
+		main_procedure(m, boost::optional<model>(), setup, &out,
+					   false, false, false, false, false, // a full search, with the cache
+					   x.gd, session_exhaustiveness, weights,
+					   1, session_seed, 0, 9, 3, log, report);
+	}
+	const fl main_seconds = main_time.elapsed();
+
+	dock_params params;
+	params.exhaustiveness = session_exhaustiveness;
+	params.seed = session_seed;
+	params.cpu = 1;
+	wall_timer first_time;
+	receptor_session session(x.receptor_pdbqt, x.gd);
+	const docked_poses poses = session.dock(x.ligand_pdbqt, params);
+	const fl first_seconds = first_time.elapsed();
+	fl again_seconds = 0;
+	bool repeatable = true;
+	VINA_FOR(r, settings.repeats) {
+		wall_timer t;
+		const docked_poses again = session.dock(x.ligand_pdbqt, params);
+		const fl seconds = t.elapsed();
+		if(r == 0 || seconds < again_seconds)
+			again_seconds = seconds;
+		if(!same(again, poses))
+			repeatable = false;
+	}
+
+	std::cout << std::fixed << std::setprecision(3)
+	          << "  main_procedure " << std::setw(9) << main_seconds << " s, " << report.mode_energies.size() << " modes\n"
+	          << "  session, first " << std::setw(9) << first_seconds << " s, with the receptor and the maps, " << poses.size() << " modes\n"
+	          << "  session, again " << std::setw(9) << again_seconds << " s\n";
+	std::cout.unsetf(std::ios::floatfield);
+	write_result(settings, "session", name + "_main_procedure", 1, "ligand", main_seconds);
+	write_result(settings, "session", name + "_first", 1, "ligand", first_seconds);
+	write_result(settings, "session", name + "_again", 1, "ligand", again_seconds);
+
+	bool energies_same = (poses.size() == report.mode_energies.size());
+	VINA_FOR_IN(i, poses)
+		if(energies_same && poses[i].energy != report.mode_energies[i])
+			energies_same = false;
+	if(!energies_same || joined(poses) != without_model_lines(out.str()))
+		regression("session", name + ": the modes differ from those of main_procedure");
+	if(!repeatable)
+		regression("session", name + ": docking the same ligand again with the maps kept gives other modes");
+
+	if(!poses.empty()) { // the best mode's energy is its intermolecular one, which is what score gives; the others are offset by their intramolecular energies
+		const fl scored = session.score(poses.front().pdbqt);
+		std::cout << "  score of the best pose " << std::fixed << std::setprecision(3) << scored << " kcal/mol against " << poses.front().energy << " docked\n";
+		std::cout.unsetf(std::ios::floatfield);
+		if(std::abs(scored - poses.front().energy) > score_tolerance) {
+			std::ostringstream what;
+			what << std::fixed << std::setprecision(3) << name << ": score of the best pose " << scored << " against " << poses.front().energy << " kcal/mol docked";
+			regression("session", what.str());
+		}
+	}
+}
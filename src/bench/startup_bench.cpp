@@ -0,0 +1,88 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <cmath> // pow
+#include <boost/thread/thread.hpp> // hardware_concurrency
+#include "bench.h"
+#include "synthetic.h"
+#include "mapped_file.h"
+#include "parse_pdbqt.h"
+#include "receptor_snapshot.h"
+
+namespace {
+	void report_startup(const bench_settings& settings, const std::string& what, sz atoms, sz repeats, fl seconds) {
+		std::cout << std::setw(18) << std::left << what << std::right
+		          << std::fixed << std::setprecision(3) << std::setw(9) << seconds / repeats << " s per receptor "
+		          << std::scientific << std::setprecision(3) << fl(atoms * repeats) / seconds << " atoms/s\n";
+		std::cout.unsetf(std::ios::floatfield);
+		write_result(settings, "startup", what, fl(atoms * repeats), "atoms", seconds);
+	}
+}
+
+void startup_bench(const bench_settings& settings) {
+	const fl atoms_per_cubic_angstrom = 0.1; // about that of a protein, hydrogens included
+	const fl half_size = 0.5 * std::pow(settings.receptor_atoms / atoms_per_cubic_angstrom, 1.0 / 3);
+	rng generator(1);
+	const path receptor_name = settings.dir / "large_receptor.pdbqt";
+	write_file(receptor_name, synthetic_receptor(settings.receptor_atoms, generator, half_size));
+	std::cout << settings.receptor_atoms << " atoms in a cube of " << std::setprecision(3) << 2 * half_size << " A, "
+	          << boost::thread::hardware_concurrency() << " hardware threads\n";
+
+	{
+		wall_timer t;
+		VINA_FOR(r, settings.repeats) {
+			mapped_file f(receptor_name);
+			parse_receptor_atoms_pdbqt(receptor_name, f.data(), f.end());
+		}
+		report_startup(settings, "parsing", settings.receptor_atoms, settings.repeats, t.elapsed());
+	}
+	{
+		wall_timer t;
+		VINA_FOR(r, settings.repeats) { // bond perception and typing
+			mapped_file f(receptor_name);
+			parse_receptor_pdbqt(receptor_name, f.data(), f.end(), settings.threads);
+		}
+		report_startup(settings, "full setup", settings.receptor_atoms, settings.repeats, t.elapsed());
+	}
+	{
+		const fl box_half_size = 10; // a typical search space
+		receptor_crop crop(vec(-box_half_size, -box_half_size, -box_half_size), vec(box_half_size, box_half_size, box_half_size), 8);
+		wall_timer t;
+		VINA_FOR(r, settings.repeats)
+			parse_receptor_pdbqt(receptor_name, crop, settings.threads);
+		report_startup(settings, "cropped setup", settings.receptor_atoms, settings.repeats, t.elapsed());
+		std::cout << "  " << crop.kept << " atoms kept near a " << 2 * box_half_size << " A box\n";
+	}
+	const path snapshot_name = settings.dir / "large_receptor.vrec";
+	{
+		mapped_file f(receptor_name);
+		write_receptor_snapshot(snapshot_name, parse_receptor_pdbqt(receptor_name, f.data(), f.end(), settings.threads));
+	}
+	{
+		wall_timer t;
+		VINA_FOR(r, settings.repeats)
+			read_receptor_snapshot(snapshot_name);
+		report_startup(settings, "snapshot loading", settings.receptor_atoms, settings.repeats, t.elapsed());
+	}
+}
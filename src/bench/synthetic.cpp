@@ -0,0 +1,86 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <cstdio> // sprintf
+#include <cmath> // abs
+#include "synthetic.h"
+
+namespace {
+	std::string atom_line(const char* record, sz serial, const char* name, const char* residue, char chain, sz residue_number, const vec& coords, fl charge, const char* type) {
+		char buf[128];
+		std::sprintf(buf, "%-6s%5u %-4s %3s %c%4u    %8.3f%8.3f%8.3f%6.2f%6.2f    %6.3f %-2s\n", record, unsigned(serial % 100000), name, residue, chain, unsigned(residue_number % 10000), coords[0], coords[1], coords[2], 1.0, 0.0, charge, type);
+		return buf;
+	}
+}
+
+std::string synthetic_receptor(sz num_atoms, rng& generator, fl half_size) {
+	const char* names[] = { "C", "N", "O", "C", "H" };
+	const char* types[] = { "C", "N", "OA", "A", "HD" };
+	const sz num_types = sizeof(types) / sizeof(types[0]);
+	const sz chain_length = 8;
+
+	std::string tmp;
+	tmp.reserve(num_atoms * 80);
+	sz serial = 0;
+	while(serial < num_atoms) {
+		vec v(random_fl(-half_size, half_size, generator), random_fl(-half_size, half_size, generator), random_fl(-half_size, half_size, generator));
+		if(std::abs(v[0]) < 5 && std::abs(v[1]) < 5 && std::abs(v[2]) < 5) continue;
+		VINA_FOR(i, chain_length) {
+			if(serial >= num_atoms) break;
+			++serial;
+			tmp += atom_line("ATOM", serial, names[serial % num_types], "ALA", 'A', serial / chain_length, v, 0.1, types[serial % num_types]);
+			v[0] += (random_int(0, 1, generator) ? 0.84 : -0.84);
+			v[1] += 0.8;
+			v[2] += (random_int(0, 1, generator) ? 0.3 : -0.3);
+		}
+	}
+	return tmp;
+}
+
+std::string synthetic_ligand(sz num_torsions) {
+	std::string tmp = "REMARK  " + to_string(num_torsions) + " active torsions\nROOT\n";
+	tmp += atom_line("ATOM", 1, "C1", "LIG", ' ', 1, vec(0,   0, 0), 0, "C");
+	tmp += atom_line("ATOM", 2, "C2", "LIG", ' ', 1, vec(1.4, 0, 0), 0, "A");
+	tmp += "ENDROOT\n";
+
+	std::vector<std::string> ends;
+	sz prev = 2;
+	sz last = 2;
+	fl x = 1.4;
+	VINA_FOR(t, num_torsions) {
+		const sz branch_atom = last + 1;
+		const sz oxygen = last + 2;
+		const fl y = (t % 2 == 0) ? -0.9 : 0.9;
+		x += 1.5;
+		const std::string branch_numbers = to_string(prev, 4) + to_string(branch_atom, 4);
+		tmp += "BRANCH" + branch_numbers + "\n";
+		tmp += atom_line("ATOM", branch_atom, ("C" + to_string(branch_atom)).c_str(), "LIG", ' ', 1, vec(x, y, 0), 0, "C");
+		tmp += atom_line("ATOM", oxygen, ("O" + to_string(oxygen)).c_str(), "LIG", ' ', 1, vec(x + 0.7, y + 1.1, 0.3), -0.3, "OA");
+		ends.push_back("ENDBRANCH" + branch_numbers + "\n");
+		prev = branch_atom;
+		last = oxygen;
+	}
+	VINA_FOR_IN(i, ends)
+		tmp += ends[ends.size() - i - 1];
+	tmp += "TORSDOF " + to_string(num_torsions) + "\n";
+	return tmp;
+}
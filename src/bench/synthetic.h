@@ -0,0 +1,37 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_BENCH_SYNTHETIC_H
+#define VINA_BENCH_SYNTHETIC_H
+
+#include <string>
+#include "random.h"
+
+// well-formed PDBQT made up on the spot, so that the benchmarks need no data files
+
+// chains of atoms scattered over a cube of the given half-size, leaving a pocket of radius 5 at the origin
+std::string synthetic_receptor(sz num_atoms, rng& generator, fl half_size = 14);
+
+// a zig-zag chain with one rotatable bond per branch, 2 + 2 * num_torsions heavy atoms
+std::string synthetic_ligand(sz num_torsions);
+
+#endif
@@ -24,6 +24,7 @@
 #define VINA_ARRAY3D_H
 
 #include <exception> // std::bad_alloc
+#include <memory> // std::allocator
 #include "common.h"
 
 inline sz checked_multiply(sz i, sz j) {
@@ -38,10 +39,10 @@ inline sz checked_multiply(sz i, sz j, sz k) {
 	return checked_multiply(checked_multiply(i, j), k);
 }
 
-template<typename T>
+template<typename T, typename A = std::allocator<T> >
 class array3d {
 	sz m_i, m_j, m_k;
-	std::vector<T> m_data;
+	std::vector<T, A> m_data;
 	friend class boost::serialization::access;
 	template<typename Archive>
 	void serialize(Archive& ar, const unsigned version) {
@@ -53,6 +54,13 @@ class array3d {
 public:
 	array3d() : m_i(0), m_j(0), m_k(0) {}
 	array3d(sz i, sz j, sz k) : m_i(i), m_j(j), m_k(k), m_data(checked_multiply(i, j, k)) {}
+	template<typename T2, typename A2>
+	explicit array3d(const array3d<T2, A2>& x) : m_i(x.dim0()), m_j(x.dim1()), m_k(x.dim2()), m_data(checked_multiply(m_i, m_j, m_k)) { // with the values converted to T
+		VINA_FOR(k, m_k)
+			VINA_FOR(j, m_j)
+				VINA_FOR(i, m_i)
+					(*this)(i, j, k) = T(x(i, j, k));
+	}
 	sz dim0() const { return m_i; }
 	sz dim1() const { return m_j; }
 	sz dim2() const { return m_k; }
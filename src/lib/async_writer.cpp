@@ -0,0 +1,107 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <algorithm> // find
+#include "async_writer.h"
+
+async_writer::async_writer(flush_policy policy_) : policy(policy_), busy(false), destructing(false), thread(aux(this)) {}
+
+async_writer::~async_writer() {
+	{
+		boost::mutex::scoped_lock self_lk(self);
+		destructing = true;
+		cond.notify_all(); // destructing modified
+	}
+	thread.join(); // the queue is emptied before the thread returns
+}
+
+void async_writer::write(std::ostream& out, std::string& data) {
+	if(data.empty()) return;
+	boost::mutex::scoped_lock self_lk(self);
+	queue.push_back(chunk(&out));
+	queue.back().data.swap(data);
+	cond.notify_all(); // queue modified
+}
+
+void async_writer::end_job() {
+	boost::mutex::scoped_lock self_lk(self);
+	queue.push_back(chunk(NULL));
+	cond.notify_all(); // queue modified
+}
+
+void async_writer::wait() {
+	boost::mutex::scoped_lock self_lk(self);
+	while(busy || !queue.empty())
+		idle.wait(self_lk);
+}
+
+void async_writer::flush_written() {
+	VINA_FOR_IN(i, written)
+		written[i]->flush();
+	written.clear();
+}
+
+void async_writer::loop() {
+	std::deque<chunk> taken;
+	while(true) {
+		{
+			boost::mutex::scoped_lock self_lk(self);
+			busy = false;
+			idle.notify_all(); // busy modified
+			while(!destructing && queue.empty())
+				cond.wait(self_lk);
+			if(queue.empty()) return; // destructing, and nothing is left
+			taken.swap(queue); // everything at once, so that the producers hardly ever wait for the lock
+			busy = true;
+		}
+		VINA_FOR_IN(i, taken) {
+			chunk& c = taken[i];
+			if(!c.out) {
+				if(policy == FLUSH_JOB)
+					flush_written();
+				continue;
+			}
+			c.out->write(c.data.data(), std::streamsize(c.data.size()));
+			if(policy == FLUSH_LINE)
+				c.out->flush();
+			else if(policy == FLUSH_JOB && std::find(written.begin(), written.end(), c.out) == written.end())
+				written.push_back(c.out);
+		}
+		taken.clear();
+	}
+}
+
+async_ostream::async_ostream(async_writer& w, std::ostream& out) : std::ostream(NULL), buf(w, out) {
+	rdbuf(&buf); // buf did not exist yet when the base was constructed
+}
+
+async_ostream::~async_ostream() {
+	flush();
+	buf.w.wait();
+}
+
+int async_ostream::buffer::sync() {
+	std::string tmp(str());
+	str(std::string());
+	w.write(out, tmp);
+	return 0;
+}
@@ -0,0 +1,86 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_ASYNC_WRITER_H
+#define VINA_ASYNC_WRITER_H
+
+#include <deque>
+#include <vector>
+#include <sstream>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/utility.hpp> // for noncopyable 
+#include "common.h"
+
+enum flush_policy {
+	FLUSH_LINE, // after every line (std::endl) or std::flush: the terminal and the log are always up to date
+	FLUSH_JOB,  // only at end_job(), e.g. once per ligand: fewer, larger writes on shared file systems
+	FLUSH_EXIT  // never - the streams are left to flush themselves, when their buffers are full or they are closed
+};
+
+// does the writing on a thread of its own, so that the threads producing the text never wait for the terminal or the disk
+struct async_writer : private boost::noncopyable {
+	async_writer(flush_policy policy_);
+	~async_writer(); // writes whatever is left first
+	void write(std::ostream& out, std::string& data); // takes the contents of data, leaving it empty
+	void end_job(); // the streams written to so far are flushed, with FLUSH_JOB
+	void wait(); // until everything passed so far has been written
+private:
+	struct chunk {
+		std::ostream* out; // NULL for the end of a job
+		std::string data;
+		chunk(std::ostream* out_) : out(out_) {}
+	};
+	void loop();
+	void flush_written();
+	struct aux {
+		async_writer* w;
+		aux(async_writer* w_) : w(w_) {}
+		void operator()() const { w->loop(); }
+	};
+	flush_policy policy;
+	std::deque<chunk> queue;
+	std::vector<std::ostream*> written; // since the last flush; used only by the writing thread
+	bool busy; // the writing thread has taken chunks off the queue and not finished with them
+	bool destructing;
+	boost::mutex self; // any modification or reading of the above should lock this first
+	boost::condition cond; // queue or destructing modified
+	boost::condition idle; // busy modified
+	boost::thread thread; // last, to start after everything else is initialized
+};
+
+// a stream that collects what is written to it, and passes it on to the writer at every std::endl or std::flush
+struct async_ostream : public std::ostream {
+	async_ostream(async_writer& w, std::ostream& out);
+	~async_ostream(); // waits for the writer, so that out can be closed right afterwards
+private:
+	struct buffer : public std::stringbuf {
+		async_writer& w;
+		std::ostream& out;
+		buffer(async_writer& w_, std::ostream& out_) : w(w_), out(out_) {}
+		int sync();
+	};
+	buffer buf;
+};
+
+#endif
@@ -24,6 +24,8 @@
 #define VINA_BFGS_H
 
 #include "matrix.h"
+#include "search_counters.h"
+#include "instrument.h"
 
 typedef triangular_matrix<fl> flmat;
 
@@ -63,7 +65,7 @@ inline bool bfgs_update(flmat& h, const Change& p, const Change& y, const fl alp
 }
 
 template<typename F, typename Conf, typename Change>
-fl line_search(F& f, sz n, const Conf& x, const Change& g, const fl f0, const Change& p, Conf& x_new, Change& g_new, fl& f1) { // returns alpha
+fl line_search(F& f, sz n, const Conf& x, const Change& g, const fl f0, const Change& p, Conf& x_new, Change& g_new, fl& f1, search_counters* counters) { // returns alpha
 	const fl c0 = 0.0001;
 	const unsigned max_trials = 10;
 	const fl multiplier = 0.5;
@@ -74,6 +76,8 @@ fl line_search(F& f, sz n, const Conf& x, const Change& g, const fl f0, const Ch
 	VINA_U_FOR(trial, max_trials) {
 		x_new = x; x_new.increment(p, alpha);
 		f1 = f(x_new, g_new);
+		if(counters)
+			++counters->line_search_trials;
 		if(f1 - f0 < c0 * alpha * pg) // FIXME check - div by norm(p) ? no?
 			break;
 		alpha *= multiplier;
@@ -93,7 +97,8 @@ void subtract_change(Change& b, const Change& a, sz n) { // b -= a
 }
 
 template<typename F, typename Conf, typename Change>
-fl bfgs(F& f, Conf& x, Change& g, const unsigned max_steps, const fl average_required_improvement, const sz over) { // x is I/O, final value is returned
+fl bfgs(F& f, Conf& x, Change& g, const unsigned max_steps, const fl average_required_improvement, const sz over, search_counters* counters = NULL) { // x is I/O, final value is returned
+	VINA_INSTRUMENT_SCOPE(INSTRUMENT_BFGS);
 	sz n = g.num_floats();
 	flmat h(n, 0);
 	set_diagonal(h, 1);
@@ -114,7 +119,9 @@ fl bfgs(F& f, Conf& x, Change& g, const unsigned max_steps, const fl average_req
 	VINA_U_FOR(step, max_steps) {
 		minus_mat_vec_product(h, g, p);
 		fl f1 = 0;
-		const fl alpha = line_search(f, n, x, g, f0, p, x_new, g_new, f1);
+		if(counters)
+			++counters->bfgs_steps;
+		const fl alpha = line_search(f, n, x, g, f0, p, x_new, g_new, f1, counters);
 		Change y(g_new); subtract_change(y, g, n);
 
 		f_values.push_back(f1);
@@ -21,6 +21,7 @@
 */
 
 #include <algorithm> // fill, etc
+#include <cmath> // ceil
 
 #if 0 // use binary cache
 	// for some reason, binary archive gives four huge warnings in VC2008
@@ -41,11 +42,31 @@
 #include "cache.h"
 #include "file.h"
 #include "szv_grid.h"
+#include "instrument.h"
 
 cache::cache(const std::string& scoring_function_version_, const grid_dims& gd_, fl slope_, atom_type::t atom_typing_used_) 
-: scoring_function_version(scoring_function_version_), gd(gd_), slope(slope_), atu(atom_typing_used_), grids(num_atom_types(atom_typing_used_)) {}
+: scoring_function_version(scoring_function_version_), gd(gd_), slope(slope_), atu(atom_typing_used_), storage(GRID_DOUBLE), grids(num_atom_types(atom_typing_used_)),
+  float_grids(num_atom_types(atom_typing_used_)), quantized_grids(num_atom_types(atom_typing_used_)) {}
 
 fl cache::eval      (const model& m, fl v) const { // needs m.coords
+	switch(storage) {
+		case GRID_FLOAT:     return eval_aux(float_grids,     m, v);
+		case GRID_QUANTIZED: return eval_aux(quantized_grids, m, v);
+		default:             return eval_aux(grids,           m, v);
+	}
+}
+
+fl cache::eval_deriv(      model& m, fl v) const { // needs m.coords, sets m.minus_forces
+	VINA_INSTRUMENT_SCOPE(INSTRUMENT_GRID_EVAL_DERIV);
+	switch(storage) {
+		case GRID_FLOAT:     return eval_deriv_aux(float_grids,     m, v);
+		case GRID_QUANTIZED: return eval_deriv_aux(quantized_grids, m, v);
+		default:             return eval_deriv_aux(grids,           m, v);
+	}
+}
+
+template<typename Grids>
+fl cache::eval_aux      (const Grids& maps, const model& m, fl v) const {
 	fl e = 0;
 	sz nat = num_atom_types(atu);
 
@@ -53,14 +74,15 @@ fl cache::eval      (const model& m, fl v) const { // needs m.coords
 		const atom& a = m.atoms[i];
 		sz t = a.get(atu);
 		if(t >= nat) continue;
-		const grid& g = grids[t];
+		const typename Grids::value_type& g = maps[t];
 		assert(g.initialized());
 		e += g.evaluate(m.coords[i], slope, v);
 	}
 	return e;
 }
 
-fl cache::eval_deriv(      model& m, fl v) const { // needs m.coords, sets m.minus_forces
+template<typename Grids>
+fl cache::eval_deriv_aux(const Grids& maps,       model& m, fl v) const {
 	fl e = 0;
 	sz nat = num_atom_types(atu);
 
@@ -68,7 +90,7 @@ fl cache::eval_deriv(      model& m, fl v) const { // needs m.coords, sets m.min
 		const atom& a = m.atoms[i];
 		sz t = a.get(atu);
 		if(t >= nat) { m.minus_forces[i].assign(0); continue; }
-		const grid& g = grids[t];
+		const typename Grids::value_type& g = maps[t];
 		assert(g.initialized());
 		vec deriv;
 		e += g.evaluate(m.coords[i], slope, v, deriv);
@@ -108,28 +130,79 @@ void cache::load(Archive& ar, const unsigned version) {
 	ar & grids;
 }
 
-void cache::populate(const model& m, const precalculate& p, const szv& atom_types_needed, bool display_progress) {
-	szv needed;
-	VINA_FOR_IN(i, atom_types_needed) {
-		sz t = atom_types_needed[i];
-		if(!grids[t].initialized()) {
-			needed.push_back(t);
-			grids[t].init(gd);
-		}
+void cache::set_coarse(fl granularity) {
+	VINA_CHECK(granularity > 0);
+	grid_dims coarse_gd = gd;
+	VINA_FOR_IN(i, coarse_gd)
+		if(coarse_gd[i].enabled())
+			coarse_gd[i].n = (std::max)(sz(1), sz(std::ceil(coarse_gd[i].span() / granularity)));
+	coarse_level.reset(new cache(scoring_function_version, coarse_gd, slope, atu));
+	coarse_level->set_storage(storage);
+}
+
+void cache::set_storage(grid_storage storage_) {
+	storage = storage_;
+	if(coarse_level)
+		coarse_level->set_storage(storage);
+}
+
+sz cache::bytes() const {
+	sz tmp = 0;
+	VINA_FOR_IN(t, grids) {
+		if(grids[t].initialized())
+			tmp += grids[t].m_data.dim0() * grids[t].m_data.dim1() * grids[t].m_data.dim2() * sizeof(fl);
+		if(float_grids[t].initialized())
+			tmp += float_grids[t].m_data.dim0() * float_grids[t].m_data.dim1() * float_grids[t].m_data.dim2() * sizeof(float);
+		if(quantized_grids[t].initialized())
+			tmp += quantized_grids[t].m_data.dim0() * quantized_grids[t].m_data.dim1() * quantized_grids[t].m_data.dim2() * sizeof(boost::uint16_t);
 	}
-	if(needed.empty())
-		return;
-	flv affinities(needed.size());
+	if(coarse_level)
+		tmp += coarse_level->bytes();
+	return tmp;
+}
+
+bool cache::initialized(sz t) const {
+	switch(storage) {
+		case GRID_FLOAT:     return float_grids[t].initialized();
+		case GRID_QUANTIZED: return quantized_grids[t].initialized();
+		default:             return grids[t].initialized();
+	}
+}
+
+igrid* cache::replicate() const {
+	cache* tmp = new cache(*this);
+	if(coarse_level)
+		tmp->coarse_level.reset(new cache(*coarse_level));
+	return tmp;
+}
+
+const igrid& cache::coarse() const {
+	if(coarse_level)
+		return *coarse_level;
+	return *this;
+}
+
+const void* cache::tables() const {
+	VINA_FOR_IN(i, grids)
+		if(initialized(i))
+			switch(storage) {
+				case GRID_FLOAT:     return &float_grids[i].m_data(0, 0, 0);
+				case GRID_QUANTIZED: return quantized_grids[i].m_data.data();
+				default:             return &grids[i].m_data(0, 0, 0);
+			}
+	return NULL;
+}
 
+template<typename Grid>
+void cache::fill(const model& m, const precalculate& p, const szv_grid& ig, const szv& types, const std::vector<Grid*>& maps) const {
+	VINA_CHECK(!maps.empty() && maps.size() == types.size());
+	flv affinities(types.size());
 	sz nat = num_atom_types(atu);
 
-	grid& g = grids[needed.front()];
+	const Grid& g = *maps.front();
 
 	const fl cutoff_sqr = p.cutoff_sqr();
 
-	grid_dims gd_reduced = szv_grid_dims(gd);
-	szv_grid ig(m, gd_reduced, cutoff_sqr);
-
 	VINA_FOR(x, g.m_data.dim0()) {
 		VINA_FOR(y, g.m_data.dim1()) {
 			VINA_FOR(z, g.m_data.dim2()) {
@@ -143,20 +216,63 @@ void cache::populate(const model& m, const precalculate& p, const szv& atom_type
 					if(t1 >= nat) continue;
 					const fl r2 = vec_distance_sqr(a.coords, probe_coords);
 					if(r2 <= cutoff_sqr) {
-						VINA_FOR_IN(j, needed) {
-							const sz t2 = needed[j];
+						VINA_FOR_IN(j, types) {
+							const sz t2 = types[j];
 							assert(t2 < nat);
 							const sz type_pair_index = triangular_matrix_index_permissive(num_atom_types(atu), t1, t2);
 							affinities[j] += p.eval_fast(type_pair_index, r2);
 						}
 					}
 				}
-				VINA_FOR_IN(j, needed) {
-					sz t = needed[j];
-					assert(t < nat);
-					grids[t].m_data(x, y, z) = affinities[j];
-				}
+				VINA_FOR_IN(j, types)
+					maps[j]->m_data(x, y, z) = affinities[j];
+			}
+		}
+	}
+}
+
+bool cache::populate(const model& m, const precalculate& p, const szv& atom_types_needed, bool display_progress) {
+	if(coarse_level)
+		coarse_level->populate(m, p, atom_types_needed, display_progress);
+	szv needed;
+	VINA_FOR_IN(i, atom_types_needed) {
+		sz t = atom_types_needed[i];
+		if(!initialized(t))
+			needed.push_back(t);
+	}
+	if(needed.empty())
+		return false;
+
+	grid_dims gd_reduced = szv_grid_dims(gd);
+	szv_grid ig(m, gd_reduced, p.cutoff_sqr());
+
+	switch(storage) {
+		case GRID_FLOAT: { // straight into the float maps
+			std::vector<float_grid*> maps;
+			VINA_FOR_IN(j, needed) {
+				float_grids[needed[j]].init(gd);
+				maps.push_back(&float_grids[needed[j]]);
+			}
+			fill(m, p, ig, needed, maps);
+			break;
+		}
+		case GRID_QUANTIZED: { // each map is quantized over its whole range, so they are done one at a time, through a single double map
+			grid g(gd);
+			const std::vector<grid*> maps(1, &g);
+			VINA_FOR_IN(j, needed) {
+				fill(m, p, ig, szv(1, needed[j]), maps);
+				quantized_grids[needed[j]] = quantized_grid(g);
+			}
+			break;
+		}
+		default: {
+			std::vector<grid*> maps;
+			VINA_FOR_IN(j, needed) {
+				grids[needed[j]].init(gd);
+				maps.push_back(&grids[needed[j]]);
 			}
+			fill(m, p, ig, needed, maps);
 		}
 	}
+	return true;
 }
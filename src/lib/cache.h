@@ -24,6 +24,7 @@
 #define VINA_CACHE_H
 
 #include <string>
+#include <boost/shared_ptr.hpp>
 #include "igrid.h"
 #include "grid.h"
 #include "model.h"
@@ -33,6 +34,10 @@ struct rigid_mismatch : public cache_mismatch {};
 struct grid_dims_mismatch : public cache_mismatch {};
 struct energy_mismatch : public cache_mismatch {};
 
+struct szv_grid;
+
+enum grid_storage { GRID_DOUBLE, GRID_FLOAT, GRID_QUANTIZED }; // how cache keeps its maps: in 8, 4 or 2 bytes a point
+
 struct cache : public igrid {
 	cache(const std::string& scoring_function_version_, const grid_dims& gd_, fl slope_, atom_type::t atom_typing_used_);
 	fl eval      (const model& m, fl v) const; // needs m.coords // clean up
@@ -41,14 +46,32 @@ struct cache : public igrid {
 	void read(const path& name); // can throw cache_mismatch
 	void write(const path& name) const;
 #endif
-	void populate(const model& m, const precalculate& p, const szv& atom_types_needed, bool display_progress = true);
+	bool populate(const model& m, const precalculate& p, const szv& atom_types_needed, bool display_progress = true); // true if it filled any maps
+	void set_coarse(fl granularity); // populate will also fill maps of the same box with this spacing, for coarse()
+	void set_storage(grid_storage storage_); // of the maps that populate fills from then on, and of the coarse ones
+	sz bytes() const; // of the maps filled so far
+	igrid* replicate() const;
+	const void* tables() const;
+	const igrid& coarse() const;
 private:
 	std::string scoring_function_version;
 	atomv atoms; // for verification
 	grid_dims gd;
 	fl slope; // does not get (de-)serialized
 	atom_type::t atu;
+	grid_storage storage;
 	std::vector<grid> grids;
+	std::vector<float_grid> float_grids;         // instead of grids, with GRID_FLOAT
+	std::vector<quantized_grid> quantized_grids; // with GRID_QUANTIZED
+	boost::shared_ptr<cache> coarse_level; // shared by the copies, but not by the replicas; does not get (de-)serialized
+
+	bool initialized(sz t) const; // in the storage in use
+	template<typename Grids>
+	fl eval_aux(const Grids& maps, const model& m, fl v) const;
+	template<typename Grids>
+	fl eval_deriv_aux(const Grids& maps, model& m, fl v) const;
+	template<typename Grid>
+	void fill(const model& m, const precalculate& p, const szv_grid& ig, const szv& types, const std::vector<Grid*>& maps) const; // maps[j] of types[j], already init'ed
 
 	friend class boost::serialization::access;
 	template<class Archive>
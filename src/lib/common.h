@@ -38,6 +38,7 @@
 
 #include <boost/serialization/vector.hpp> // can't come before the above two - wart fixed in upcoming Boost versions
 #include <boost/serialization/base_object.hpp> // movable_atom needs it - (derived from atom)
+#include <boost/serialization/is_bitwise_serializable.hpp>
 #include <boost/filesystem/path.hpp> // typedef'ed
 
 #include "macros.h"
@@ -129,6 +130,8 @@ private:
 	}
 };
 
+BOOST_IS_BITWISE_SERIALIZABLE(vec) // vecv is then read and written as one block by binary archives
+
 inline vec operator*(fl s, const vec& v) {
 	return vec(s * v[0], s * v[1], s * v[2]);
 }
@@ -176,8 +179,16 @@ struct mat {
 			data[i] *= s;
 		return *this;
 	}
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & data;
+	}
 };
 
+BOOST_IS_BITWISE_SERIALIZABLE(mat)
+
 
 typedef std::vector<vec> vecv;
 typedef std::pair<vec, vec> vecp;
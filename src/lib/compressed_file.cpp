@@ -0,0 +1,144 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <iterator> // back_inserter
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#ifdef VINA_ZSTD
+#include <boost/iostreams/filter/zstd.hpp>
+#endif
+#include "compressed_file.h"
+#include "file.h"
+
+compression_format detect_compression(const char* begin, const char* end) {
+	const sz size = end - begin;
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(begin);
+	if(size >= 2 && p[0] == 0x1f && p[1] == 0x8b)
+		return COMPRESSION_GZIP;
+	if(size >= 4 && p[0] == 0x28 && p[1] == 0xb5 && p[2] == 0x2f && p[3] == 0xfd)
+		return COMPRESSION_ZSTD;
+	return COMPRESSION_NONE;
+}
+
+compression_format detect_compression(const path& name) {
+	char magic[4] = { 0, 0, 0, 0 };
+	ifile in(name, std::ios::binary);
+	in.read(magic, sizeof(magic));
+	return detect_compression(magic, magic + in.gcount());
+}
+
+compression_format compression_from_name(const path& name) {
+	const std::string ext = name.extension().string();
+	if(ext == ".gz")  return COMPRESSION_GZIP;
+	if(ext == ".zst") return COMPRESSION_ZSTD;
+	return COMPRESSION_NONE;
+}
+
+namespace {
+	const std::string zstd_unavailable = "zstd compression is not supported by this build (see VINA_ZSTD)";
+
+	void push_decompressor(boost::iostreams::filtering_istream& in, compression_format format, const path& name) {
+		switch(format) {
+			case COMPRESSION_NONE: break;
+			case COMPRESSION_GZIP: in.push(boost::iostreams::gzip_decompressor()); break;
+#ifdef VINA_ZSTD
+			case COMPRESSION_ZSTD: in.push(boost::iostreams::zstd_decompressor()); break;
+#else
+			case COMPRESSION_ZSTD: throw compression_error(name, zstd_unavailable);
+#endif
+		}
+	}
+
+	struct checked_sink { // writes through the stream rather than its buffer, so that a failure sticks to the stream
+		typedef char char_type;
+		typedef boost::iostreams::sink_tag category;
+		explicit checked_sink(std::ostream& out_) : out(&out_) {}
+		std::streamsize write(const char* s, std::streamsize n) {
+			out->write(s, n);
+			return n;
+		}
+	private:
+		std::ostream* out;
+	};
+}
+
+void decompress(const path& name, compression_format format, const char* begin, const char* end, std::vector<char>& out) {
+	boost::iostreams::filtering_istream in;
+	push_decompressor(in, format, name);
+	in.push(boost::iostreams::array_source(begin, end - begin));
+	out.clear();
+	try {
+		boost::iostreams::copy(in, boost::iostreams::back_inserter(out));
+	}
+	catch(std::exception& e) { // gzip_error, zstd_error, truncated input
+		throw compression_error(name, e.what());
+	}
+}
+
+izfile::izfile(const path& name) : format(detect_compression(name)) {
+	push_decompressor(*this, format, name);
+	boost::iostreams::file_source source(name.string(), std::ios::binary);
+	if(!source.is_open())
+		throw file_error(name, true);
+	push(source);
+}
+
+ozfile::ozfile(const path& name_) : name(name_) {
+	switch(compression_from_name(name)) {
+		case COMPRESSION_NONE: break;
+		case COMPRESSION_GZIP: push(boost::iostreams::gzip_compressor()); break;
+#ifdef VINA_ZSTD
+		case COMPRESSION_ZSTD: push(boost::iostreams::zstd_compressor()); break;
+#else
+		case COMPRESSION_ZSTD: throw compression_error(name, zstd_unavailable);
+#endif
+	}
+	file.open(name, std::ios::binary);
+	if(!file)
+		throw file_error(name, false);
+	push(checked_sink(file));
+}
+
+void ozfile::close() {
+	if(!file.is_open()) return; // closed already
+	bool written = false;
+	try {
+		flush();
+		reset(); // closes the chain, so that the compressor writes its trailer
+		written = true;
+	}
+	catch(std::exception&) {} // from the compressor
+	file.close(); // flushes what is left; a full disk is seen here at the latest
+	if(!written || !file)
+		throw file_error(name, false);
+}
+
+ozfile::~ozfile() {
+	try {
+		reset();
+	}
+	catch(...) {} // only when close was not called, as when an exception is on its way out
+}
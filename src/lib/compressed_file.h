@@ -0,0 +1,62 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_COMPRESSED_FILE_H
+#define VINA_COMPRESSED_FILE_H
+
+#include <vector>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include "common.h"
+
+// gzip input is recognized by its magic bytes, and output is compressed when its name ends in ".gz"
+// zstd (".zst") needs VINA_ZSTD to be defined at build time, and libzstd
+
+enum compression_format { COMPRESSION_NONE, COMPRESSION_GZIP, COMPRESSION_ZSTD };
+
+struct compression_error {
+	path name;
+	std::string reason;
+	compression_error(const path& name_, const std::string& reason_) : name(name_), reason(reason_) {}
+};
+
+compression_format detect_compression(const char* begin, const char* end); // from the magic bytes
+compression_format detect_compression(const path& name); // from the first bytes of the file; can throw file_error
+compression_format compression_from_name(const path& name); // from the extension
+
+void decompress(const path& name, compression_format format, const char* begin, const char* end, std::vector<char>& out); // can throw compression_error
+
+struct izfile : public boost::iostreams::filtering_istream { // plain or compressed, decompressed as it is read
+	izfile(const path& name); // can throw file_error, compression_error
+	compression_format format;
+};
+
+struct ozfile : public boost::iostreams::filtering_ostream { // compressed as it is written, if the name says so
+	ozfile(const path& name_); // can throw file_error, compression_error
+	void close(); // flushes, writes the trailer of the compressed formats and closes the file; can throw file_error
+	~ozfile(); // closes, if close was not called, ignoring any failure
+private:
+	path name;
+	boost::filesystem::ofstream file; // the end of the chain, kept here so that a failed write is seen when it is closed
+};
+
+#endif
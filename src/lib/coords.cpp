@@ -21,6 +21,7 @@
 */
 
 #include "coords.h"
+#include "parallel.h"
 
 fl rmsd_upper_bound(const vecv& a, const vecv& b) {
 	VINA_CHECK(a.size() == b.size());
@@ -40,19 +41,171 @@ std::pair<sz, fl> find_closest(const vecv& a, const output_container& b) {
 	return tmp;
 }
 
-void add_to_output_container(output_container& out, const output_type& t, fl min_rmsd, sz max_size) {
-	std::pair<sz, fl> closest_rmsd = find_closest(t.coords, out);
-	if(closest_rmsd.first < out.size() && closest_rmsd.second < min_rmsd) { // have a very similar one
-		if(t.e < out[closest_rmsd.first].e) { // the new one is better, apparently
-			out[closest_rmsd.first] = t; // FIXME? slow
+vec centroid(const vecv& a) {
+	vec tmp(0, 0, 0);
+	VINA_FOR_IN(i, a)
+		tmp += a[i];
+	if(!a.empty())
+		tmp *= 1.0 / a.size();
+	return tmp;
+}
+
+struct x_less {
+	bool operator()(const vec& a, fl x) const { return a[0] < x; }
+	bool operator()(const vec& a, const vec& b) const { return a[0] < b[0]; }
+};
+
+element_buckets::element_buckets(const vecv& coords, const szv& elements) {
+	VINA_CHECK(coords.size() == elements.size());
+	VINA_FOR_IN(i, coords) {
+		sz el = elements[i];
+		if(el >= buckets.size())
+			buckets.resize(el + 1);
+		buckets[el].push_back(coords[i]);
+	}
+	VINA_FOR_IN(i, buckets)
+		std::sort(buckets[i].begin(), buckets[i].end(), x_less());
+}
+
+fl element_buckets::closest_sqr(const vec& v, sz el) const {
+	fl tmp = max_fl;
+	if(el >= buckets.size()) return tmp;
+	const vecv& b = buckets[el];
+	const vecv::const_iterator start = std::lower_bound(b.begin(), b.end(), v[0], x_less());
+	for(vecv::const_iterator it = start; it != b.end(); ++it) { // to the right
+		if(sqr((*it)[0] - v[0]) >= tmp) break;
+		fl r2 = vec_distance_sqr(*it, v);
+		if(r2 < tmp) tmp = r2;
+	}
+	for(vecv::const_iterator it = start; it != b.begin(); ) { // to the left
+		--it;
+		if(sqr((*it)[0] - v[0]) >= tmp) break;
+		fl r2 = vec_distance_sqr(*it, v);
+		if(r2 < tmp) tmp = r2;
+	}
+	return tmp;
+}
+
+fl rmsd_lower_bound_asymmetric(const vecv& a, const szv& a_elements, const element_buckets& b) {
+	VINA_CHECK(a.size() == a_elements.size());
+	fl sum = 0;
+	VINA_FOR_IN(i, a) {
+		fl r2 = b.closest_sqr(a[i], a_elements[i]);
+		assert(not_max(r2));
+		sum += r2;
+	}
+	return a.empty() ? 0 : std::sqrt(sum / a.size());
+}
+
+fl rmsd_lower_bound(const vecv& a, const szv& a_elements, const vecv& b, const szv& b_elements) {
+	return (std::max)(rmsd_lower_bound_asymmetric(a, a_elements, element_buckets(b, b_elements)),
+	                  rmsd_lower_bound_asymmetric(b, b_elements, element_buckets(a, a_elements)));
+}
+
+struct rmsd_lower_bound_matrix_aux {
+	const output_container* out;
+	const szv* elements;
+	const std::vector<element_buckets>* buckets;
+	triangular_matrix<fl>* result;
+	rmsd_lower_bound_matrix_aux(const output_container* out_, const szv* elements_, const std::vector<element_buckets>* buckets_, triangular_matrix<fl>* result_)
+		: out(out_), elements(elements_), buckets(buckets_), result(result_) {}
+	void operator()(sz i) const { // row i, to the right of the diagonal
+		const vecv& a = (*out)[i].coords;
+		(*result)(i, i) = 0;
+		VINA_RANGE(j, i+1, out->size()) {
+			const vecv& b = (*out)[j].coords;
+			(*result)(i, j) = (std::max)(rmsd_lower_bound_asymmetric(a, *elements, (*buckets)[j]),
+			                             rmsd_lower_bound_asymmetric(b, *elements, (*buckets)[i]));
+		}
+	}
+};
+
+triangular_matrix<fl> rmsd_lower_bound_matrix(const output_container& out, const szv& elements, sz num_threads) {
+	triangular_matrix<fl> tmp(out.size(), 0);
+	std::vector<element_buckets> buckets;
+	buckets.reserve(out.size());
+	VINA_FOR_IN(i, out)
+		buckets.push_back(element_buckets(out[i].coords, elements));
+	rmsd_lower_bound_matrix_aux aux(&out, &elements, &buckets, &tmp);
+	if(num_threads > 1 && out.size() > 1) {
+		parallel_for<rmsd_lower_bound_matrix_aux, true> pf(&aux, num_threads); // rows differ in length
+		pf.run(out.size());
+	}
+	else
+		VINA_FOR_IN(i, out)
+			aux(i);
+	return tmp;
+}
+
+output_store::cell_index output_store::index_of(const vec& v) const {
+	cell_index tmp;
+	VINA_FOR_IN(i, tmp)
+		tmp[i] = (min_rmsd > 0) ? int(std::floor(v[i] / min_rmsd)) : 0; // without a min_rmsd, a single cell
+	return tmp;
+}
+
+const output_type* output_store::find_similar(const output_type& t, const vec& t_centroid) const {
+	const output_type* tmp = NULL;
+	if(!(min_rmsd > 0)) return tmp; // nothing is ever similar
+	fl best = min_rmsd;
+	const cell_index center = index_of(t_centroid);
+	VINA_I_RANGE(dx, -1, 2)
+	VINA_I_RANGE(dy, -1, 2)
+	VINA_I_RANGE(dz, -1, 2) {
+		cell_index ci = center;
+		ci[0] += dx; ci[1] += dy; ci[2] += dz;
+		cell_map::const_iterator it = cells.find(ci);
+		if(it == cells.end()) continue;
+		VINA_FOR_IN(i, it->second) {
+			const output_type* p = it->second[i];
+			fl res = rmsd_upper_bound(t.coords, p->coords);
+			if(res < best || (tmp && res == best && p->e < tmp->e)) { // ties go to the better pose, as in a linear scan
+				best = res;
+				tmp = p;
+			}
+		}
+	}
+	return tmp;
+}
+
+void output_store::insert(const output_type& t, const vec& t_centroid) {
+	output_container::iterator it = std::upper_bound(poses.begin(), poses.end(), t);
+	it = poses.insert(it, new output_type(t));
+	cells[index_of(t_centroid)].push_back(&(*it));
+}
+
+void output_store::erase(const output_type* p) {
+	cell_map::iterator c = cells.find(index_of(centroid(p->coords)));
+	VINA_CHECK(c != cells.end());
+	cell& entries = c->second;
+	cell::iterator e = std::find(entries.begin(), entries.end(), p);
+	VINA_CHECK(e != entries.end());
+	entries.erase(e);
+	if(entries.empty())
+		cells.erase(c);
+	VINA_FOR_IN(i, poses)
+		if(&poses[i] == p) {
+			poses.erase(poses.begin() + i);
+			return;
+		}
+	VINA_CHECK(false);
+}
+
+void output_store::add(const output_type& t) {
+	const vec t_centroid = centroid(t.coords);
+	const output_type* similar = find_similar(t, t_centroid);
+	if(similar) { // have a very similar one
+		if(t.e < similar->e) { // the new one is better, apparently
+			erase(similar);
+			insert(t, t_centroid);
 		}
 	}
 	else { // nothing similar
-		if(out.size() < max_size)
-			out.push_back(new output_type(t)); // the last one had the worst energy - replacing 
-		else
-			if(!out.empty() && t.e < out.back().e) // FIXME? - just changed
-				out.back() = t; // FIXME? slow
+		if(poses.size() < max_size)
+			insert(t, t_centroid);
+		else if(!poses.empty() && t.e < poses.back().e) { // replacing the one with the worst energy
+			erase(&poses.back());
+			insert(t, t_centroid);
+		}
 	}
-	out.sort();
 }
@@ -23,12 +23,66 @@
 #ifndef VINA_COORDS_H
 #define VINA_COORDS_H
 
+#include <map>
+#include <boost/array.hpp>
 #include "conf.h"
 #include "atom.h" // for atomv
+#include "matrix.h"
 
 fl rmsd_upper_bound(const vecv& a, const vecv& b);
+vec centroid(const vecv& a); // zero_vec for empty a
 std::pair<sz, fl> find_closest(const vecv& a, const output_container& b);
-void add_to_output_container(output_container& out, const output_type& t, fl min_rmsd, sz max_size);
+
+// atoms bucketed by element and sorted along x within each bucket, so that the closest atom of the same
+// element is found by scanning outwards from a binary search, rather than by looking at every atom
+class element_buckets {
+public:
+	element_buckets(const vecv& coords, const szv& elements);
+	fl closest_sqr(const vec& v, sz el) const; // max_fl if there are no atoms of element el
+private:
+	std::vector<vecv> buckets;
+};
+
+// symmetry-aware lower bounds: each atom is matched to the closest atom of the same element in the other set
+// coords and elements are those of heavy atoms, as in output_type::coords and model::get_heavy_atom_movable_elements
+fl rmsd_lower_bound_asymmetric(const vecv& a, const szv& a_elements, const element_buckets& b);
+fl rmsd_lower_bound(const vecv& a, const szv& a_elements, const vecv& b, const szv& b_elements);
+triangular_matrix<fl> rmsd_lower_bound_matrix(const output_container& out, const szv& elements, sz num_threads); // all pairs of out[i].coords
+
+// Keeps at most max_size poses, sorted by energy, no two of which are closer than min_rmsd.
+// The distance between centroids is a lower bound on the RMSD, so poses are hashed by centroid
+// on a grid with min_rmsd spacing, and only those in the 27 neighbouring cells are compared.
+class output_store {
+public:
+	output_store(fl min_rmsd_, sz max_size_) : min_rmsd(min_rmsd_), max_size(max_size_) {}
+	void add(const output_type& t); // t.coords should be set
+	void add(const output_container& in) {
+		VINA_FOR_IN(i, in)
+			add(in[i]);
+	}
+	sz size() const { return poses.size(); }
+	bool empty() const { return poses.empty(); }
+	const output_container& container() const { return poses; }
+	void transfer(output_container& out) { // out receives the poses, the store is left empty
+		out.clear();
+		out.swap(poses);
+		cells.clear();
+	}
+private:
+	typedef boost::array<int, 3> cell_index;
+	typedef std::vector<const output_type*> cell;
+	typedef std::map<cell_index, cell> cell_map;
+
+	cell_index index_of(const vec& v) const;
+	const output_type* find_similar(const output_type& t, const vec& t_centroid) const; // the closest pose within min_rmsd, or NULL
+	void insert(const output_type& t, const vec& t_centroid);
+	void erase(const output_type* p);
+
+	fl min_rmsd;
+	sz max_size;
+	output_container poses; // sorted by energy
+	cell_map cells;
+};
 
 
 #endif
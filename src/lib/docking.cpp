@@ -0,0 +1,566 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <string>
+#include <vector>
+#include <cmath> // pow, ceil
+#include <iomanip> // for setprecision, fixed
+#include <sstream>
+#include <boost/timer.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include "docking.h"
+#include "parallel_mc.h"
+#include "parallel.h"
+#include "non_cache.h"
+#include "naive_non_cache.h"
+#include "quasi_newton.h"
+#include "coords.h" // output_store
+#include "trace.h"
+
+void doing(int verbosity, const std::string& str, tee& log) {
+	if(verbosity > 1) {
+		log << str << std::string(" ... ");
+		log.flush();
+	}
+}
+
+void done(int verbosity, tee& log) {
+	if(verbosity > 1) {
+		log << "done.";
+		log.endl();
+	}
+}
+
+void done_with_time(int verbosity, tee& log, double elapsed_time) {
+	if(verbosity > 1) {
+		log << "done (elapsed time: " << std::fixed << std::setprecision(3) << elapsed_time << "s).";
+		log.endl();
+	}
+}
+
+grid_dims search_space(const vec& center, const vec& size, fl granularity) {
+	grid_dims tmp;
+	VINA_FOR_IN(i, tmp) {
+		tmp[i].n = sz(std::ceil(size[i] / granularity));
+		fl real_span = granularity * tmp[i].n;
+		tmp[i].begin = center[i] - real_span/2;
+		tmp[i].end = tmp[i].begin + real_span;
+	}
+	return tmp;
+}
+
+void write_all_output(model& m, const output_container& out, sz how_many,
+				  std::ostream& f,
+				  const std::vector<std::string>& remarks) {
+	if(out.size() < how_many)
+		how_many = out.size();
+	VINA_CHECK(how_many <= remarks.size());
+	VINA_FOR(i, how_many) {
+		m.set(out[i].c);
+		m.write_model(f, i+1, remarks[i]); // so that model numbers start with 1
+	}
+}
+
+struct clash_free_flag { // the lowest index of the randomization tasks that have found a clash-free conformation so far
+	clash_free_flag(sz num_tasks) : value(num_tasks) {} // num_tasks if none has
+	void set(sz task) {
+		boost::mutex::scoped_lock self_lk(self);
+		if(task < value)
+			value = task;
+	}
+	sz get() {
+		boost::mutex::scoped_lock self_lk(self);
+		return value;
+	}
+private:
+	boost::mutex self;
+	sz value;
+};
+
+struct randomization_task {
+	sz index;
+	model m;
+	rng generator;
+	sz attempts;
+	sz attempted;
+	conf best_conf;
+	fl best_clash_penalty;
+	randomization_task(sz index_, const model& m_, int seed, sz attempts_) : index(index_), m(m_), generator(static_cast<rng::result_type>(seed)), attempts(attempts_), attempted(0), best_clash_penalty(max_fl) {}
+};
+
+typedef boost::ptr_vector<randomization_task> randomization_task_container;
+
+struct randomization_aux {
+	const conf* init_conf;
+	const vec* corner1;
+	const vec* corner2;
+	clash_free_flag* clash_free; // NULL unless stopping early
+	// a task only gives up once a lower one has found a clash-free conformation, so the lowest task to find one within its attempts does,
+	// and which conformation is chosen does not depend on the timing of the threads
+	randomization_aux(const conf* init_conf_, const vec* corner1_, const vec* corner2_, clash_free_flag* clash_free_)
+		: init_conf(init_conf_), corner1(corner1_), corner2(corner2_), clash_free(clash_free_) {}
+	void operator()(randomization_task& t) const {
+		const sz check_every = 16; // attempts between looks at the shared flag
+		VINA_FOR(i, t.attempts) {
+			if(clash_free && i % check_every == 0 && clash_free->get() < t.index)
+				break;
+			conf c = *init_conf;
+			c.randomize(*corner1, *corner2, t.generator);
+			t.m.set(c);
+			fl penalty = t.m.clash_penalty();
+			++t.attempted;
+			if(i == 0 || penalty < t.best_clash_penalty) {
+				t.best_conf = c;
+				t.best_clash_penalty = penalty;
+				if(clash_free && penalty <= 0) {
+					clash_free->set(t.index);
+					break;
+				}
+			}
+		}
+	}
+};
+
+void do_randomization(model& m,
+					  std::ostream& out,
+					  const vec& corner1, const vec& corner2, int seed, int verbosity, sz num_threads, bool stop_when_clash_free, tee& log) {
+	conf init_conf = m.get_initial_conf();
+	rng generator(static_cast<rng::result_type>(seed));
+	if(verbosity > 1) {
+		log << "Using random seed: " << seed;
+		log.endl();
+		log << "Attempting to find low-clash initial conformation...";
+		log.endl();
+	}
+	const sz attempts = 10000;
+	if(num_threads < 1) num_threads = 1;
+	if(num_threads > attempts) num_threads = attempts;
+
+	// one task per thread; a single task uses the seed itself, so that its result does not depend on how many threads there are
+	randomization_task_container tasks;
+	VINA_FOR(i, num_threads) {
+		const int task_seed = (num_threads == 1) ? seed : random_int(0, 1000000, generator);
+		const sz task_attempts = attempts / num_threads + ((i < attempts % num_threads) ? 1 : 0);
+		tasks.push_back(new randomization_task(i, m, task_seed, task_attempts));
+	}
+	clash_free_flag clash_free(tasks.size());
+	randomization_aux aux(&init_conf, &corner1, &corner2, stop_when_clash_free ? &clash_free : NULL);
+	if(num_threads == 1)
+		aux(tasks.front());
+	else {
+		parallel_iter<randomization_aux, randomization_task_container, randomization_task, true> parallel_iter_instance(&aux, num_threads);
+		parallel_iter_instance.run(tasks);
+	}
+
+	sz best = 0; // the lowest clash-free task when stopping early, or else the least clash, with ties going to the lower task index
+	sz attempted = 0;
+	VINA_FOR_IN(i, tasks) {
+		attempted += tasks[i].attempted; // unlike the choice, this depends on the timing when stopping early
+		if(stop_when_clash_free && clash_free.get() < tasks.size())
+			best = clash_free.get();
+		else if(tasks[i].attempted > 0 && (tasks[best].attempted == 0 || tasks[i].best_clash_penalty < tasks[best].best_clash_penalty))
+			best = i;
+		if(verbosity > 2) {
+			log << "  Task " << (i+1) << "/" << tasks.size() << ": best clash penalty = " << tasks[i].best_clash_penalty << " after " << tasks[i].attempted << " attempts";
+			log.endl();
+		}
+	}
+	VINA_CHECK(tasks[best].attempted > 0);
+	m.set(tasks[best].best_conf);
+	if(verbosity > 1) {
+		log << "Best clash penalty found: " << tasks[best].best_clash_penalty;
+		if(attempted < attempts)
+			log << " (stopped after " << attempted << " of " << attempts << " attempts)";
+		log.endl();
+	}
+	m.write_structure(out);
+}
+
+void refine_structure(model& m, const precalculate& prec, non_cache& nc, output_type& out, const vec& cap, sz max_steps = 1000) {
+	change g(m.get_size());
+	quasi_newton quasi_newton_par;
+	quasi_newton_par.max_steps = max_steps;
+	const fl slope_orig = nc.slope;
+	VINA_FOR(p, 5) {
+		nc.slope = 100 * std::pow(10.0, 2.0*p);
+		quasi_newton_par(m, prec, nc, out, g, cap);
+		m.set(out.c); // just to be sure
+		if(nc.within(m))
+			break;
+	}
+	out.coords = m.get_heavy_atom_movable_coords();
+	if(!nc.within(m))
+		out.e = max_fl;
+	nc.slope = slope_orig;
+}
+
+struct refine_worker { // refine_structure modifies the model and nc.slope
+	model m;
+	non_cache nc;
+	refine_worker(const model& m_, const non_cache& nc_) : m(m_), nc(nc_) {}
+};
+
+typedef boost::ptr_vector<refine_worker> refine_worker_container;
+
+struct refine_aux {
+	refine_worker_container* workers;
+	const precalculate* prec;
+	output_container* out;
+	const vec* cap;
+	sz max_steps;
+	refine_aux(refine_worker_container* workers_, const precalculate* prec_, output_container* out_, const vec* cap_, sz max_steps_)
+		: workers(workers_), prec(prec_), out(out_), cap(cap_), max_steps(max_steps_) {}
+	void operator()(sz i) const { // parallel_for gives thread k the indexes i with i % num_threads == k
+		refine_worker& w = (*workers)[i % workers->size()];
+		trace_span span("refine", "refinement", i);
+		refine_structure(w.m, *prec, w.nc, (*out)[i], *cap, max_steps);
+	}
+};
+
+void refine_structures(model& m, const precalculate& prec, non_cache& nc, output_container& out, const vec& cap, sz max_steps, sz num_threads) {
+	const sz num_workers = (std::min)(num_threads, out.size());
+	if(num_workers <= 1) {
+		VINA_FOR_IN(i, out) {
+			trace_span span("refine", "refinement", i);
+			refine_structure(m, prec, nc, out[i], cap, max_steps);
+		}
+		return;
+	}
+	refine_worker_container workers;
+	VINA_FOR(i, num_workers)
+		workers.push_back(new refine_worker(m, nc));
+	refine_aux aux(&workers, &prec, &out, &cap, max_steps);
+	parallel_for<refine_aux> pf(&aux, num_workers);
+	pf.run(out.size());
+}
+
+std::string vina_remark(fl e, fl lb, fl ub) {
+	std::ostringstream remark;
+	remark.setf(std::ios::fixed, std::ios::floatfield);
+	remark.setf(std::ios::showpoint);
+	remark << "REMARK VINA RESULT: " 
+		                << std::setw(9) << std::setprecision(1) << e
+	                    << "  " << std::setw(9) << std::setprecision(3) << lb
+						<< "  " << std::setw(9) << std::setprecision(3) << ub
+						<< '\n';
+	return remark.str();
+}
+
+output_container remove_redundant(const output_container& in, fl min_rmsd) {
+	output_store store(min_rmsd, in.size());
+	store.add(in);
+	output_container tmp;
+	store.transfer(tmp);
+	return tmp;
+}
+
+void do_search(model& m, const boost::optional<model>& ref, const scoring_function& sf, const precalculate& prec, const igrid& ig, const precalculate& prec_widened, const igrid& ig_widened, non_cache& nc, // nc.slope is changed
+			   std::ostream* out_stream, // NULL if score_only
+			   const vec& corner1, const vec& corner2,
+			   const parallel_mc& par, fl energy_range, sz num_modes,
+			   int seed, int verbosity, bool score_only, bool local_only, tee& log, const terms& t, const flv& weights, job_report& report) {
+	VINA_CHECK(score_only || out_stream);
+	conf_size s = m.get_size();
+	conf c = m.get_initial_conf();
+	fl e = max_fl;
+	const vec authentic_v(1000, 1000, 1000);
+	if(score_only) {
+		fl intramolecular_energy = m.eval_intramolecular(prec, authentic_v, c);
+		naive_non_cache nnc(&prec); // for out of grid issues
+		e = m.eval_adjusted(sf, prec, nnc, authentic_v, c, intramolecular_energy);
+		log << "Affinity: " << std::fixed << std::setprecision(5) << e << " (kcal/mol)";
+		log.endl();
+		flv term_values = t.evale_robust(m);
+		VINA_CHECK(term_values.size() == 5);
+		log << "Intermolecular contributions to the terms, before weighting:\n";
+		log << std::setprecision(5);
+		log << "    gauss 1     : " << term_values[0] << '\n';
+		log << "    gauss 2     : " << term_values[1] << '\n';
+		log << "    repulsion   : " << term_values[2] << '\n';
+		log << "    hydrophobic : " << term_values[3] << '\n';
+		log << "    Hydrogen    : " << term_values[4] << '\n';
+		VINA_CHECK(weights.size() == term_values.size() + 1);
+		fl e2 = 0;
+		VINA_FOR_IN(i, term_values)
+			e2 += term_values[i] * weights[i];
+		e2 = sf.conf_independent(m, e2);
+		if(e < 100 && std::abs(e2 - e) > 0.05) {
+			log << "WARNING: the individual terms are inconsisent with the\n";
+			log << "WARNING: affinity. Consider reporting this as a bug:\n";
+			log << "WARNING: http://vina.scripps.edu/manual.html#bugs\n";
+		}
+	}
+	else if(local_only) {
+		output_type out(c, e);
+		doing(verbosity, "Performing local search", log);
+		traced_phase refine_time("refine");
+		refine_structure(m, prec, nc, out, authentic_v, par.mc.ssd_par.evals);
+		done(verbosity, log);
+		fl intramolecular_energy = m.eval_intramolecular(prec, authentic_v, out.c);
+		e = m.eval_adjusted(sf, prec, nc, authentic_v, out.c, intramolecular_energy);
+		report.refine = refine_time.end();
+		report.num_modes = 1;
+		report.best_energy = e;
+		report.mode_energies.push_back(e);
+
+		log << "Affinity: " << std::fixed << std::setprecision(5) << e << " (kcal/mol)";
+		log.endl();
+		if(!nc.within(m))
+			log << "WARNING: not all movable atoms are within the search space\n";
+
+		doing(verbosity, "Writing output", log);
+		output_container out_cont;
+		out_cont.push_back(new output_type(out));
+		std::vector<std::string> remarks(1, vina_remark(e, 0, 0));
+		traced_phase output_time("output");
+		write_all_output(m, out_cont, 1, *out_stream, remarks); // how_many == 1
+		report.output = output_time.end();
+		done(verbosity, log);
+	}
+	else {
+		rng generator(static_cast<rng::result_type>(seed));
+		log << "Using random seed: " << seed;
+		log.endl();
+		output_container out_cont;
+		
+		if(verbosity > 1) {
+			log << "Search parameters:";
+			log.endl();
+			log << "  Number of runs: " << par.num_tasks;
+			log.endl();
+			log << "  Steps per run: " << par.mc.num_steps;
+			log.endl();
+			log << "  Number of threads: " << par.num_threads;
+			log.endl();
+		}
+		
+		boost::timer search_timer;
+		traced_phase search_time("search");
+		doing(verbosity, "Performing search", log);
+		par(m, out_cont, prec, ig, prec_widened, ig_widened, corner1, corner2, generator, &report.stats);
+		report.search = search_time.end();
+		done_with_time(verbosity, log, search_timer.elapsed());
+
+		if(verbosity > 1 && (numa_nodes() > 1 || par.numa.pin_threads || par.numa.grids != NUMA_FIRST_TOUCH)) {
+			log << "NUMA: " << numa_nodes() << " node" << (numa_nodes() > 1 ? "s" : "") << ", grids on the node of the thread for "
+				<< report.stats.local_tasks << " of " << par.num_tasks << " runs";
+			if(report.stats.local_tasks + report.stats.remote_tasks < par.num_tasks)
+				log << " (not known for " << (par.num_tasks - report.stats.local_tasks - report.stats.remote_tasks) << ")";
+			log.endl();
+		}
+		
+		if(verbosity > 1) {
+			log << "Search produced " << out_cont.size() << " initial results";
+			log.endl();
+			if(!out_cont.empty()) {
+				log << "Best energy found: " << std::fixed << std::setprecision(3) << out_cont.front().e << " (kcal/mol)";
+				log.endl();
+			}
+		}
+
+		boost::timer refine_timer;
+		traced_phase refine_time("refine");
+		doing(verbosity, "Refining results", log);
+		refine_structures(m, prec, nc, out_cont, authentic_v, par.mc.ssd_par.evals, par.num_threads);
+
+		if(!out_cont.empty()) {
+			out_cont.sort();
+			const fl best_mode_intramolecular_energy = m.eval_intramolecular(prec, authentic_v, out_cont[0].c);
+			VINA_FOR_IN(i, out_cont)
+				if(not_max(out_cont[i].e))
+					out_cont[i].e = m.eval_adjusted(sf, prec, nc, authentic_v, out_cont[i].c, best_mode_intramolecular_energy); 
+			// the order must not change because of non-decreasing g (see paper), but we'll re-sort in case g is non strictly increasing
+			out_cont.sort();
+		}
+
+		const fl out_min_rmsd = 1;
+		out_cont = remove_redundant(out_cont, out_min_rmsd);
+		report.refine = refine_time.end();
+
+		done_with_time(verbosity, log, refine_timer.elapsed());
+		
+		if(verbosity > 1 && !out_cont.empty()) {
+			log << "After refinement, " << out_cont.size() << " unique conformations";
+			log.endl();
+		}
+
+		log.setf(std::ios::fixed, std::ios::floatfield);
+		log.setf(std::ios::showpoint);
+		log << '\n';
+		log << "mode |   affinity | dist from best mode\n";
+		log << "     | (kcal/mol) | rmsd l.b.| rmsd u.b.\n";
+		log << "-----+------------+----------+----------\n";
+
+		model best_mode_model = m;
+		if(!out_cont.empty())
+			best_mode_model.set(out_cont.front().c);
+
+		sz how_many = 0;
+		std::vector<std::string> remarks;
+		VINA_FOR_IN(i, out_cont) {
+			if(how_many >= num_modes || !not_max(out_cont[i].e) || out_cont[i].e > out_cont[0].e + energy_range) break; // check energy_range sanity FIXME
+			++how_many;
+			log << std::setw(4) << i+1
+				<< "    " << std::setw(9) << std::setprecision(1) << out_cont[i].e; // intermolecular_energies[i];
+			m.set(out_cont[i].c);
+			const model& r = ref ? ref.get() : best_mode_model;
+			const fl lb = m.rmsd_lower_bound(r);
+			const fl ub = m.rmsd_upper_bound(r);
+			log << "  " << std::setw(9) << std::setprecision(3) << lb
+			    << "  " << std::setw(9) << std::setprecision(3) << ub; // FIXME need user-readable error messages in case of failures
+
+			remarks.push_back(vina_remark(out_cont[i].e, lb, ub));
+			log.endl();
+		}
+		doing(verbosity, "Writing output", log);
+		traced_phase output_time("output");
+		write_all_output(m, out_cont, how_many, *out_stream, remarks);
+		report.output = output_time.end();
+		done(verbosity, log);
+		report.num_modes = how_many;
+		VINA_FOR(i, how_many)
+			report.mode_energies.push_back(out_cont[i].e);
+		if(how_many > 0)
+			report.best_energy = out_cont[0].e;
+
+		if(how_many < 1) {
+			log << "WARNING: Could not find any conformations completely within the search space.\n"
+				<< "WARNING: Check that it is large enough for all movable atoms, including those in the flexible side chains.";
+			log.endl();
+		}
+	}
+}
+
+void main_procedure(model& m, const boost::optional<model>& ref, // m is non-const (FIXME?)
+				 scoring_setup& setup,
+			     std::ostream* out_stream, // NULL if score_only
+				 bool score_only, bool local_only, bool randomize_only, bool randomize_until_clash_free, bool no_cache,
+				 const grid_dims& gd, int exhaustiveness,
+				 const flv& weights,
+				 int cpu, int seed, int verbosity, sz num_modes, fl energy_range, tee& log, job_report& report) {
+
+	const everything& t = setup.t;
+	const weighted_terms& wt = setup.wt;
+	const precalculate& prec = setup.prec;
+	const precalculate& prec_widened = setup.prec_widened;
+
+	vec corner1(gd[0].begin, gd[1].begin, gd[2].begin);
+	vec corner2(gd[0].end,   gd[1].end,   gd[2].end);
+	
+	if(verbosity > 1 && !score_only) {
+		fl size_x = corner2[0] - corner1[0];
+		fl size_y = corner2[1] - corner1[1];
+		fl size_z = corner2[2] - corner1[2];
+		fl volume = size_x * size_y * size_z;
+		
+		log << "Search space:";
+		log.endl();
+		log << "  Center: (" << std::fixed << std::setprecision(3) 
+		    << (corner1[0] + corner2[0])/2 << ", " 
+		    << (corner1[1] + corner2[1])/2 << ", " 
+		    << (corner1[2] + corner2[2])/2 << ")";
+		log.endl();
+		log << "  Size: (" << std::fixed << std::setprecision(3) 
+		    << size_x << " x " 
+		    << size_y << " x " 
+		    << size_z << ") Angstrom";
+		log.endl();
+		log << "  Volume: " << std::fixed << std::setprecision(1) 
+		    << volume << " Angstrom^3";
+		log.endl();
+	}
+
+	parallel_mc par;
+	sz heuristic = m.num_movable_atoms() + 10 * m.get_size().num_degrees_of_freedom();
+	par.mc.num_steps = unsigned(70 * 3 * (50 + heuristic) / 2); // 2 * 70 -> 8 * 20 // FIXME
+	par.mc.ssd_par.evals = unsigned((25 + m.num_movable_atoms()) / 3);
+	par.mc.min_rmsd = 1.0;
+	par.mc.num_saved_mins = 20;
+	par.mc.hunt_cap = vec(10, 10, 10);
+	par.num_tasks = exhaustiveness;
+	par.num_threads = cpu;
+	par.display_progress = (verbosity > 1);
+	par.progress_stream = log.console;
+	par.numa = setup.numa;
+	
+	if(verbosity > 1 && !score_only) {
+		log << "Ligand information:";
+		log.endl();
+		log << "  Movable atoms: " << m.num_movable_atoms();
+		log.endl();
+		log << "  Degrees of freedom: " << m.get_size().num_degrees_of_freedom();
+		log.endl();
+		log << "  Computed heuristic: " << heuristic;
+		log.endl();
+	}
+
+	const fl slope = setup.slope;
+	if(randomize_only) {
+		VINA_CHECK(out_stream);
+		do_randomization(m, *out_stream,
+			             corner1, corner2, seed, verbosity, cpu, randomize_until_clash_free, log);
+	}
+	else {
+		non_cache nc        (m, gd, &prec,         slope); // if gd has 0 n's, this will not constrain anything
+		non_cache nc_widened(m, gd, &prec_widened, slope); // if gd has 0 n's, this will not constrain anything
+		if(no_cache) {
+			do_search(m, ref, wt, prec, nc, prec_widened, nc_widened, nc,
+					  out_stream,
+					  corner1, corner2,
+					  par, energy_range, num_modes,
+					  seed, verbosity, score_only, local_only, log, t, weights, report);
+		}
+		else {
+			bool cache_needed = !(score_only || randomize_only || local_only);
+			boost::timer cache_timer;
+			traced_phase grid_time("grid");
+			if(cache_needed) doing(verbosity, "Analyzing the binding site", log);
+			cache& c = setup.c;
+			if(cache_needed) {
+				numa_interleaving interleaving(setup.numa.grids == NUMA_INTERLEAVE);
+				if(setup.sparse)
+					setup.sparse->populate(m, prec, m.get_movable_atom_types(prec.atom_typing_used()));
+				else if(c.populate(m, prec, m.get_movable_atom_types(prec.atom_typing_used())) || !setup.replicas) { // kept for the ligands that need no new maps
+					setup.replicas.reset(); // the old copies go first
+					setup.replicas.reset(new node_grids(c, setup.numa.grids == NUMA_REPLICATE));
+				}
+			}
+			if(cache_needed) done_with_time(verbosity, log, cache_timer.elapsed());
+			report.grid = grid_time.end();
+			const igrid& ig = setup.sparse ? static_cast<const igrid&>(*setup.sparse) : c;
+			if(!setup.sparse)
+				par.replicas = setup.replicas.get();
+			do_search(m, ref, wt, prec, ig, prec, ig, nc,
+					  out_stream,
+					  corner1, corner2,
+					  par, energy_range, num_modes,
+					  seed, verbosity, score_only, local_only, log, t, weights, report);
+			if(verbosity > 1 && setup.sparse && cache_needed) {
+				const sz computed = setup.sparse->bricks_computed();
+				log << "Grid bricks computed so far: " << computed << " of " << setup.sparse->bricks_total()
+					<< " (" << std::fixed << std::setprecision(1) << computed * brick_array3d::brick_points * sizeof(fl) / 1048576.0 << " MB)";
+				log.endl();
+			}
+		}
+	}
+}
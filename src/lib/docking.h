@@ -0,0 +1,92 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_DOCKING_H
+#define VINA_DOCKING_H
+
+#include <iostream>
+#include <string>
+#include <boost/optional.hpp>
+#include <boost/utility.hpp> // for noncopyable
+#include <boost/scoped_ptr.hpp>
+#include "everything.h"
+#include "weighted_terms.h"
+#include "precalculate.h"
+#include "cache.h"
+#include "sparse_cache.h"
+#include "non_cache.h"
+#include "tee.h"
+#include "job_report.h"
+#include "locality.h"
+
+// what vina does with a ligand once everything is parsed, here rather than in main, so that the benchmarks dock the same way
+
+void doing(int verbosity, const std::string& str, tee& log);
+void done(int verbosity, tee& log);
+void done_with_time(int verbosity, tee& log, double elapsed_time);
+
+grid_dims search_space(const vec& center, const vec& size, fl granularity = 0.375); // the grid for --center_* and --size_*
+
+void refine_structures(model& m, const precalculate& prec, non_cache& nc, output_container& out, const vec& cap, sz max_steps, sz num_threads); // nc.slope is changed meanwhile
+
+struct grid_options { // how the maps are computed and kept (vina --coarse_grid, --sparse_grids, --grid_storage, --numa_grids, --cpu_affinity)
+	fl coarse;            // the spacing of coarse maps for the hunting phase, if not 0
+	bool sparse;          // the maps computed in bricks, as the search reaches them
+	grid_storage storage;
+	numa_settings numa;   // for the search threads and the maps
+	grid_options() : coarse(0), sparse(false), storage(GRID_DOUBLE) {}
+};
+
+struct scoring_setup : private boost::noncopyable { // everything that does not depend on the ligand, so that a whole library is docked with the same grids
+	everything t;
+	weighted_terms wt;
+	precalculate prec;
+	precalculate prec_widened;
+	fl slope;
+	cache c; // populated with the atom types of each ligand as it comes
+	boost::scoped_ptr<sparse_cache> sparse; // used instead of c, if not NULL
+	numa_settings numa; // for the search threads and c
+	boost::scoped_ptr<node_grids> replicas; // of c on the other NUMA nodes, with NUMA_REPLICATE; made again only when populate fills more maps
+	scoring_setup(const flv& weights, const grid_dims& gd, const grid_options& grids = grid_options())
+		: wt(&t, weights), prec(wt), prec_widened(prec), slope(1e6), // FIXME: slope too large? used to be 100
+		  c("scoring_function_version001", gd, slope, atom_type::XS), numa(grids.numa) {
+		VINA_CHECK(weights.size() == 6);
+		const fl left  = 0.25; 
+		const fl right = 0.25;
+		prec_widened.widen(left, right);
+		if(grids.coarse > 0)
+			c.set_coarse(grids.coarse);
+		c.set_storage(grids.storage);
+		if(grids.sparse)
+			sparse.reset(new sparse_cache(gd, slope, atom_type::XS));
+	}
+};
+
+void main_procedure(model& m, const boost::optional<model>& ref, // m is non-const (FIXME?)
+				 scoring_setup& setup,
+			     std::ostream* out_stream, // NULL if score_only
+				 bool score_only, bool local_only, bool randomize_only, bool randomize_until_clash_free, bool no_cache,
+				 const grid_dims& gd, int exhaustiveness,
+				 const flv& weights,
+				 int cpu, int seed, int verbosity, sz num_modes, fl energy_range, tee& log, job_report& report);
+
+#endif
@@ -0,0 +1,186 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_FLAT_ARCHIVE_H
+#define VINA_FLAT_ARCHIVE_H
+
+#include <cstring> // memcpy
+#include <boost/cstdint.hpp>
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/is_enum.hpp>
+#include <boost/mpl/bool.hpp>
+#include "model.h"
+
+// archives for models that are read back many times (see ligand_archive.h, receptor_snapshot.h)
+// Boost archives spend as long per ligand on class bookkeeping as parsing the PDBQT takes, so these are used instead:
+// they take the same serialize() members, but only the types models are made of,
+// and copy primitives and bitwise serializable vectors (see BOOST_IS_BITWISE_SERIALIZABLE) as they are in memory
+
+template<typename T>
+struct is_flat_primitive : public boost::mpl::bool_<boost::is_arithmetic<T>::value || boost::is_enum<T>::value> {};
+
+struct flat_oarchive {
+	flat_oarchive(std::string& out_) : out(out_) {} // appends to out
+	template<typename T>
+	flat_oarchive& operator&(const T& x) { save(x); return *this; }
+private:
+	std::string& out;
+	void bytes(const void* p, sz n) { out.append(static_cast<const char*>(p), n); }
+	template<typename T>
+	void save(const T& x) { save(x, is_flat_primitive<T>()); }
+	template<typename T>
+	void save(const T& x, boost::mpl::true_) { bytes(&x, sizeof(T)); }
+	template<typename T>
+	void save(const T& x, boost::mpl::false_) { boost::serialization::access::serialize(*this, const_cast<T&>(x), 0); }
+	template<typename T, std::size_t N>
+	void save(const T (&x)[N]) {
+		VINA_FOR(i, N)
+			save(x[i]);
+	}
+	template<typename T>
+	void save(const std::vector<T>& x) {
+		save(boost::uint64_t(x.size()));
+		save_elements(x, boost::serialization::is_bitwise_serializable<T>());
+	}
+	template<typename T>
+	void save_elements(const std::vector<T>& x, boost::mpl::true_) { if(!x.empty()) bytes(&x[0], x.size() * sizeof(T)); }
+	template<typename T>
+	void save_elements(const std::vector<T>& x, boost::mpl::false_) {
+		VINA_FOR_IN(i, x)
+			save(x[i]);
+	}
+	void save(const std::string& x) {
+		save(boost::uint64_t(x.size()));
+		bytes(x.data(), x.size());
+	}
+	template<typename A, typename B>
+	void save(const std::pair<A, B>& x) {
+		save(x.first);
+		save(x.second);
+	}
+	template<typename T>
+	void save(const boost::optional<T>& x) {
+		save(bool(x));
+		if(x)
+			save(x.get());
+	}
+	void save(const qt& x) {
+		save(x.R_component_1());
+		save(x.R_component_2());
+		save(x.R_component_3());
+		save(x.R_component_4());
+	}
+};
+
+struct flat_archive_error {}; // the data ends too early, or a size is impossible
+
+struct archive_error { // a ligand archive or receptor snapshot that can not be used
+	path name;
+	std::string reason;
+	archive_error(const path& name_, const std::string& reason_) : name(name_), reason(reason_) {}
+};
+
+struct flat_iarchive { // [begin, end) should hold exactly one object
+	flat_iarchive(const char* begin_, const char* end_) : p(begin_), end(end_) {}
+	template<typename T>
+	flat_iarchive& operator&(T& x) { load(x); return *this; }
+	model load_model() { // can throw flat_archive_error
+		model tmp; // the default c'tor is private
+		*this & tmp;
+		if(p != end)
+			throw flat_archive_error();
+		return tmp;
+	}
+private:
+	const char* p;
+	const char* end;
+	void bytes(void* q, sz n) {
+		if(sz(end - p) < n)
+			throw flat_archive_error();
+		std::memcpy(q, p, n);
+		p += n;
+	}
+	sz load_size(sz min_element_size) { // the check keeps a corrupt size from being allocated
+		boost::uint64_t n = 0;
+		load(n);
+		if(n > (end - p) / min_element_size)
+			throw flat_archive_error();
+		return sz(n);
+	}
+	template<typename T>
+	void load(T& x) { load(x, is_flat_primitive<T>()); }
+	template<typename T>
+	void load(T& x, boost::mpl::true_) { bytes(&x, sizeof(T)); }
+	template<typename T>
+	void load(T& x, boost::mpl::false_) { boost::serialization::access::serialize(*this, x, 0); }
+	template<typename T, std::size_t N>
+	void load(T (&x)[N]) {
+		VINA_FOR(i, N)
+			load(x[i]);
+	}
+	template<typename T>
+	void load(std::vector<T>& x) {
+		load_elements(x, boost::serialization::is_bitwise_serializable<T>());
+	}
+	template<typename T>
+	void load_elements(std::vector<T>& x, boost::mpl::true_) {
+		x.resize(load_size(sizeof(T)));
+		if(!x.empty()) bytes(&x[0], x.size() * sizeof(T));
+	}
+	template<typename T>
+	void load_elements(std::vector<T>& x, boost::mpl::false_) {
+		x.resize(load_size(1));
+		VINA_FOR_IN(i, x)
+			load(x[i]);
+	}
+	void load(std::string& x) {
+		x.resize(load_size(1));
+		if(!x.empty()) bytes(&x[0], x.size());
+	}
+	template<typename A, typename B>
+	void load(std::pair<A, B>& x) {
+		load(x.first);
+		load(x.second);
+	}
+	template<typename T>
+	void load(boost::optional<T>& x) {
+		bool present = false;
+		load(present);
+		if(present) {
+			T tmp;
+			load(tmp);
+			x = tmp;
+		}
+		else
+			x = boost::none;
+	}
+	void load(qt& x) {
+		fl a, b, c, d;
+		load(a);
+		load(b);
+		load(c);
+		load(d);
+		x = qt(a, b, c, d);
+	}
+};
+
+#endif
@@ -0,0 +1,137 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <map>
+#include <boost/thread/mutex.hpp>
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+#include "huge_pages.h"
+
+namespace {
+	enum allocation_kind { ALLOCATED_RESERVED, ALLOCATED_TRANSPARENT, ALLOCATED_MAPPED, ALLOCATED_NEW };
+
+	struct allocation {
+		allocation_kind kind;
+		sz bytes;  // asked for
+		sz mapped; // mmap'ed, 0 for new
+	};
+
+	huge_pages_mode current_mode = HUGE_PAGES_TRANSPARENT;
+
+	boost::mutex allocations_mutex;
+	std::map<const void*, allocation>& allocations() { // the large ones made here, so that each is freed the way it was made
+		static std::map<const void*, allocation> tmp;
+		return tmp;
+	}
+
+	sz round_up(sz bytes) { return (bytes + huge_page_size - 1) / huge_page_size * huge_page_size; }
+
+#ifndef WIN32
+	void* map_reserved(sz mapped) {
+#ifdef MAP_HUGETLB
+		void* p = ::mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if(p != MAP_FAILED)
+			return p;
+#endif
+		return NULL; // none reserved, or not enough left
+	}
+
+	void* map_aligned(sz mapped) { // on a huge page boundary, so that the kernel can back all of it with huge pages
+		void* p = ::mmap(NULL, mapped + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(p == MAP_FAILED)
+			return NULL;
+		char* begin = static_cast<char*>(p);
+		char* end = begin + mapped + huge_page_size;
+		char* aligned = begin + (huge_page_size - reinterpret_cast<sz>(begin) % huge_page_size) % huge_page_size;
+		if(aligned > begin)
+			::munmap(begin, aligned - begin); // the unaligned head and tail are given back
+		if(end > aligned + mapped)
+			::munmap(aligned + mapped, end - (aligned + mapped));
+		return aligned;
+	}
+#endif
+}
+
+void set_huge_pages(huge_pages_mode mode) {
+	current_mode = mode;
+}
+
+huge_page_counts huge_pages_allocated() {
+	boost::mutex::scoped_lock lk(allocations_mutex);
+	huge_page_counts tmp;
+	const std::map<const void*, allocation>& a = allocations();
+	for(std::map<const void*, allocation>::const_iterator i = a.begin(); i != a.end(); ++i)
+		switch(i->second.kind) {
+			case ALLOCATED_RESERVED:    tmp.reserved    += i->second.bytes; break;
+			case ALLOCATED_TRANSPARENT: tmp.transparent += i->second.bytes; break;
+			default:                    tmp.ordinary    += i->second.bytes; break;
+		}
+	return tmp;
+}
+
+void* allocate_large(sz bytes) {
+	allocation a;
+	a.kind = ALLOCATED_NEW;
+	a.bytes = bytes;
+	a.mapped = 0;
+	void* p = NULL;
+#ifndef WIN32
+	if(current_mode != HUGE_PAGES_OFF) {
+		a.mapped = round_up(bytes);
+		if(current_mode == HUGE_PAGES_RESERVED && (p = map_reserved(a.mapped)) != NULL)
+			a.kind = ALLOCATED_RESERVED;
+		else if((p = map_aligned(a.mapped)) != NULL) {
+			a.kind = ALLOCATED_MAPPED;
+#ifdef MADV_HUGEPAGE
+			if(::madvise(p, a.mapped, MADV_HUGEPAGE) == 0)
+				a.kind = ALLOCATED_TRANSPARENT;
+#endif
+		}
+		else
+			a.mapped = 0;
+	}
+#endif
+	if(!p)
+		p = ::operator new(bytes); // can throw std::bad_alloc
+	boost::mutex::scoped_lock lk(allocations_mutex);
+	allocations()[p] = a;
+	return p;
+}
+
+void deallocate_large(void* p, sz bytes) {
+	allocation a;
+	{
+		boost::mutex::scoped_lock lk(allocations_mutex);
+		std::map<const void*, allocation>::iterator i = allocations().find(p);
+		VINA_CHECK(i != allocations().end() && i->second.bytes == bytes);
+		a = i->second;
+		allocations().erase(i);
+	}
+#ifndef WIN32
+	if(a.mapped > 0) {
+		::munmap(p, a.mapped);
+		return;
+	}
+#endif
+	::operator delete(p);
+}
@@ -0,0 +1,75 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_HUGE_PAGES_H
+#define VINA_HUGE_PAGES_H
+
+#include <memory> // allocator
+#include <new> // bad_alloc
+#include "common.h"
+
+// the large tables that are read at random (the grids of the cache, the precalculated pair energies) are allocated here,
+// in huge pages when the system has them, so that far fewer TLB entries cover them: transparent huge pages (madvise) by default,
+// or the ones reserved by the administrator (MAP_HUGETLB, see /proc/sys/vm/nr_hugepages); whatever does not work falls back
+// to ordinary pages, and allocations smaller than huge_page_threshold are left to new
+
+enum huge_pages_mode { HUGE_PAGES_OFF, HUGE_PAGES_TRANSPARENT, HUGE_PAGES_RESERVED };
+
+void set_huge_pages(huge_pages_mode mode); // for the allocations from then on; before starting the threads
+
+struct huge_page_counts { // bytes allocated at the moment, by how they were
+	sz reserved;    // in reserved huge pages
+	sz transparent; // advised to be in transparent huge pages (whether the kernel does it is up to its settings)
+	sz ordinary;    // in ordinary pages
+	huge_page_counts() : reserved(0), transparent(0), ordinary(0) {}
+};
+
+huge_page_counts huge_pages_allocated();
+
+const sz huge_page_size = 2 * 1024 * 1024; // the usual one on x86-64
+const sz huge_page_threshold = huge_page_size / 2; // at most half of what is mapped is wasted
+
+void* allocate_large  (sz bytes); // can throw std::bad_alloc
+void  deallocate_large(void* p, sz bytes);
+
+template<typename T>
+struct huge_page_allocator : public std::allocator<T> {
+	template<typename U> struct rebind { typedef huge_page_allocator<U> other; };
+	huge_page_allocator() {}
+	huge_page_allocator(const huge_page_allocator&) : std::allocator<T>() {}
+	template<typename U> huge_page_allocator(const huge_page_allocator<U>&) {}
+	T* allocate(sz n, const void* = 0) {
+		if(n > max_sz / sizeof(T))
+			throw std::bad_alloc();
+		if(n * sizeof(T) < huge_page_threshold)
+			return std::allocator<T>::allocate(n);
+		return static_cast<T*>(allocate_large(n * sizeof(T)));
+	}
+	void deallocate(T* p, sz n) {
+		if(n * sizeof(T) < huge_page_threshold)
+			std::allocator<T>::deallocate(p, n);
+		else
+			deallocate_large(p, n * sizeof(T));
+	}
+};
+
+#endif
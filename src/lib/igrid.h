@@ -28,8 +28,12 @@
 struct model; // forward declaration
 
 struct igrid { // grids interface (that cache, etc. conform to)
+	virtual ~igrid() {}
 	virtual fl eval      (const model& m, fl v) const = 0; // needs m.coords // clean up
 	virtual fl eval_deriv(      model& m, fl v) const = 0; // needs m.coords, sets m.minus_forces // clean up
+	virtual igrid* replicate() const { return NULL; } // a copy in memory allocated by the calling thread, for grids worth keeping one of on each NUMA node; the caller owns it
+	virtual const void* tables() const { return NULL; } // somewhere in the memory read by eval, to tell which NUMA node it is on
+	virtual const igrid& coarse() const { return *this; } // a rougher, cheaper version, for the first local optimization of each Monte Carlo step
 };
 
 #endif
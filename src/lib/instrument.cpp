@@ -0,0 +1,83 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <time.h> // clock_gettime
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/tss.hpp>
+#include "instrument.h"
+
+const char* instrument_point_name(sz i) {
+	static const char* const names[INSTRUMENT_POINTS] = { "model_eval_deriv", "grid_eval_deriv", "bfgs", "mutate_conf" };
+	VINA_CHECK(i < INSTRUMENT_POINTS);
+	return names[i];
+}
+
+#ifdef VINA_INSTRUMENT
+
+bool instrumentation_on = false;
+
+#ifdef __GNUC__
+namespace {
+	__thread instrument_counts* current = NULL; // much cheaper than boost::thread_specific_ptr
+}
+instrument_counts* instrument_current() { return current; }
+void instrument_set_current(instrument_counts* c) { current = c; }
+#else
+namespace {
+	void no_cleanup(instrument_counts*) {} // not owned
+	boost::thread_specific_ptr<instrument_counts> current(no_cleanup);
+}
+instrument_counts* instrument_current() { return current.get(); }
+void instrument_set_current(instrument_counts* c) { current.reset(c); }
+#endif
+
+boost::uint64_t instrument_now() {
+#ifdef CLOCK_MONOTONIC
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return boost::uint64_t(t.tv_sec) * 1000000000u + boost::uint64_t(t.tv_nsec);
+#else
+	static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+	return boost::uint64_t((boost::posix_time::microsec_clock::universal_time() - epoch).total_microseconds()) * 1000u;
+#endif
+}
+
+void set_instrumentation(bool on) { instrumentation_on = on; }
+bool instrumentation_enabled() { return instrumentation_on; }
+
+instrument_install::instrument_install(instrument_counts* c) : previous(instrument_current()) {
+	instrument_set_current(c);
+}
+
+instrument_install::~instrument_install() {
+	instrument_set_current(previous);
+}
+
+#else
+
+void set_instrumentation(bool) {}
+bool instrumentation_enabled() { return false; }
+
+instrument_install::instrument_install(instrument_counts*) : previous(NULL) {}
+instrument_install::~instrument_install() {}
+
+#endif
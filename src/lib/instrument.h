@@ -0,0 +1,114 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_INSTRUMENT_H
+#define VINA_INSTRUMENT_H
+
+#include <boost/cstdint.hpp>
+#include "common.h"
+
+// counts and times the calls of the inner loops, for each thread separately
+//
+// compiled in only with -DVINA_INSTRUMENT, otherwise VINA_INSTRUMENT_SCOPE expands to nothing;
+// even then, it does nothing until set_instrumentation(true), and then only on the threads that
+// have an instrument_counts installed (see instrument_install), which they own, so no atomics are needed.
+// Times are inclusive: that of model::eval_deriv includes the grid's, and bfgs includes both.
+
+enum instrument_point {
+	INSTRUMENT_MODEL_EVAL_DERIV,
+	INSTRUMENT_GRID_EVAL_DERIV,
+	INSTRUMENT_BFGS,
+	INSTRUMENT_MUTATE_CONF,
+	INSTRUMENT_POINTS
+};
+
+const char* instrument_point_name(sz i); // i < INSTRUMENT_POINTS
+
+struct instrument_counts {
+	boost::uint64_t calls      [INSTRUMENT_POINTS];
+	boost::uint64_t nanoseconds[INSTRUMENT_POINTS];
+	instrument_counts() {
+		VINA_FOR(i, INSTRUMENT_POINTS) {
+			calls[i] = 0;
+			nanoseconds[i] = 0;
+		}
+	}
+	instrument_counts& operator+=(const instrument_counts& x) {
+		VINA_FOR(i, INSTRUMENT_POINTS) {
+			calls[i]       += x.calls[i];
+			nanoseconds[i] += x.nanoseconds[i];
+		}
+		return *this;
+	}
+	bool empty() const {
+		VINA_FOR(i, INSTRUMENT_POINTS)
+			if(calls[i] > 0)
+				return false;
+		return true;
+	}
+};
+
+#ifdef VINA_INSTRUMENT
+const bool instrumentation_compiled = true;
+#else
+const bool instrumentation_compiled = false;
+#endif
+
+void set_instrumentation(bool on); // before starting the threads; does nothing unless compiled in
+bool instrumentation_enabled();
+
+struct instrument_install { // the calling thread counts into c until the end of the scope
+	instrument_install(instrument_counts* c);
+	~instrument_install();
+private:
+	instrument_counts* previous;
+};
+
+#ifdef VINA_INSTRUMENT
+
+extern bool instrumentation_on;
+instrument_counts* instrument_current(); // of the calling thread, NULL if none
+boost::uint64_t instrument_now(); // nanoseconds, monotonic
+
+struct instrument_scope {
+	instrument_scope(instrument_point point_) : counts(instrumentation_on ? instrument_current() : NULL), point(point_), start(counts ? instrument_now() : 0) {}
+	~instrument_scope() {
+		if(counts) {
+			++counts->calls[point];
+			counts->nanoseconds[point] += instrument_now() - start;
+		}
+	}
+private:
+	instrument_counts* counts;
+	instrument_point point;
+	boost::uint64_t start;
+};
+
+#define VINA_INSTRUMENT_SCOPE(point) instrument_scope instrument_scope_instance(point)
+
+#else
+
+#define VINA_INSTRUMENT_SCOPE(point)
+
+#endif
+
+#endif
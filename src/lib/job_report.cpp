@@ -0,0 +1,150 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <ostream>
+#include <iomanip>
+#include <cstdio> // sprintf
+#include "job_report.h"
+
+report_format report_format_from_name(const path& name) {
+	const std::string s = name.string();
+	const std::string csv = ".csv";
+	if(s.size() >= csv.size() && s.compare(s.size() - csv.size(), csv.size(), csv) == 0)
+		return REPORT_CSV;
+	return REPORT_JSON;
+}
+
+namespace {
+	const char* const phase_names[] = { "parse", "precalculate", "grid", "search", "refine", "output" };
+	const sz num_phases = sizeof(phase_names) / sizeof(phase_names[0]);
+
+	const phase_time& phase(const job_report& r, sz i) {
+		switch(i) {
+			case 0:  return r.parse;
+			case 1:  return r.precalculate;
+			case 2:  return r.grid;
+			case 3:  return r.search;
+			case 4:  return r.refine;
+			default: return r.output;
+		}
+	}
+
+	std::string json_string(const std::string& s) {
+		std::string tmp = "\"";
+		VINA_FOR_IN(i, s) {
+			const char c = s[i];
+			if(c == '"' || c == '\\') {
+				tmp += '\\';
+				tmp += c;
+			}
+			else if(static_cast<unsigned char>(c) < 0x20) {
+				char buf[8];
+				std::sprintf(buf, "\\u%04x", unsigned(c));
+				tmp += buf;
+			}
+			else
+				tmp += c;
+		}
+		return tmp + '"';
+	}
+
+	std::string csv_string(const std::string& s) {
+		if(s.find_first_of(",\"\n\r") == std::string::npos)
+			return s;
+		std::string tmp = "\"";
+		VINA_FOR_IN(i, s) {
+			if(s[i] == '"')
+				tmp += '"';
+			tmp += s[i];
+		}
+		return tmp + '"';
+	}
+
+	void write_energy(std::ostream& out, const job_report& r, const char* none) {
+		if(r.num_modes > 0)
+			out << r.best_energy;
+		else
+			out << none;
+	}
+}
+
+void write_report_header(std::ostream& out, report_format format) {
+	if(format != REPORT_CSV)
+		return;
+	out << "ligand,index,model,tag,docked";
+	VINA_FOR(i, num_phases)
+		out << ',' << phase_names[i] << "_wall," << phase_names[i] << "_cpu";
+	out << ",evals,bfgs_steps,line_search_trials,mc_steps,mc_accepted,mc_acceptance_rate,thread_busy,numa_local_tasks,numa_remote_tasks,num_modes,best_energy";
+	if(instrumentation_enabled())
+		VINA_FOR(i, INSTRUMENT_POINTS)
+			out << ',' << instrument_point_name(i) << "_calls," << instrument_point_name(i) << "_seconds";
+	out << std::endl;
+}
+
+void write_report(std::ostream& out, report_format format, const job_report& r) {
+	const std::ios::fmtflags flags = out.flags();
+	const std::streamsize precision = out.precision();
+	out.unsetf(std::ios::floatfield);
+	out << std::setprecision(6);
+
+	const search_counters& c = r.stats.counters;
+	const instrument_counts& ins = r.stats.instrument;
+	if(format == REPORT_CSV) {
+		out << csv_string(r.ligand) << ',' << r.index << ',' << r.model << ',' << csv_string(r.tag) << ',' << (r.docked ? 1 : 0);
+		VINA_FOR(i, num_phases)
+			out << ',' << phase(r, i).wall << ',' << phase(r, i).cpu;
+		out << ',' << c.evals << ',' << c.bfgs_steps << ',' << c.line_search_trials << ',' << c.mc_steps << ',' << c.mc_accepted << ',' << c.mc_acceptance_rate() << ',';
+		VINA_FOR_IN(i, r.stats.thread_busy) // one column, as their number varies
+			out << (i > 0 ? ";" : "") << r.stats.thread_busy[i];
+		out << ',' << r.stats.local_tasks << ',' << r.stats.remote_tasks;
+		out << ',' << r.num_modes << ',';
+		write_energy(out, r, "");
+		if(instrumentation_enabled())
+			VINA_FOR(i, INSTRUMENT_POINTS)
+				out << ',' << ins.calls[i] << ',' << ins.nanoseconds[i] / 1e9;
+	}
+	else {
+		out << "{\"ligand\": " << json_string(r.ligand) << ", \"index\": " << r.index << ", \"model\": " << r.model << ", \"tag\": " << json_string(r.tag) << ", \"docked\": " << (r.docked ? "true" : "false");
+		out << ", \"phases\": {";
+		VINA_FOR(i, num_phases)
+			out << (i > 0 ? ", " : "") << '"' << phase_names[i] << "\": {\"wall\": " << phase(r, i).wall << ", \"cpu\": " << phase(r, i).cpu << '}';
+		out << "}, \"counters\": {\"evals\": " << c.evals << ", \"bfgs_steps\": " << c.bfgs_steps << ", \"line_search_trials\": " << c.line_search_trials
+		    << ", \"mc_steps\": " << c.mc_steps << ", \"mc_accepted\": " << c.mc_accepted << ", \"mc_acceptance_rate\": " << c.mc_acceptance_rate() << '}';
+		out << ", \"thread_busy\": [";
+		VINA_FOR_IN(i, r.stats.thread_busy)
+			out << (i > 0 ? ", " : "") << r.stats.thread_busy[i];
+		out << "], \"numa\": {\"local_tasks\": " << r.stats.local_tasks << ", \"remote_tasks\": " << r.stats.remote_tasks << '}';
+		out << ", \"num_modes\": " << r.num_modes << ", \"best_energy\": ";
+		write_energy(out, r, "null");
+		if(instrumentation_enabled()) {
+			out << ", \"instrument\": {";
+			VINA_FOR(i, INSTRUMENT_POINTS)
+				out << (i > 0 ? ", " : "") << '"' << instrument_point_name(i) << "\": {\"calls\": " << ins.calls[i] << ", \"seconds\": " << ins.nanoseconds[i] / 1e9 << '}';
+			out << '}';
+		}
+		out << '}';
+	}
+	out << std::endl;
+
+	out.flags(flags);
+	out.precision(precision);
+}
@@ -0,0 +1,61 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_JOB_REPORT_H
+#define VINA_JOB_REPORT_H
+
+#include <iosfwd>
+#include <string>
+#include "timers.h"
+#include "search_counters.h"
+
+// one record per docked ligand, for finding bottlenecks across many jobs without scraping the logs:
+// JSON Lines (one object per line) by default, or CSV, with a header line, if the name ends in ".csv";
+// with instrumentation on (see instrument.h), the calls and times of the inner loops are included
+
+struct job_report {
+	std::string ligand; // file name
+	sz index;           // 1-based, within a library (slice); 1 otherwise
+	sz model;           // in a library, which molecule it is, whichever slice has it (see ligand_library::model_number); 0 otherwise
+	std::string tag;    // and what its MODEL line says (see ligand_library::model_tag)
+	bool docked;        // false if the ligand was skipped
+	// the one-time setup (receptor parsing, precalculation) is charged to the first ligand
+	phase_time parse;
+	phase_time precalculate;
+	phase_time grid;     // populating the grid cache with the ligand's atom types
+	phase_time search;
+	phase_time refine;
+	phase_time output;
+	search_stats stats;  // of the search phase
+	sz num_modes;
+	fl best_energy;      // max_fl if no modes
+	flv mode_energies;   // of the modes written, best first (not in the records)
+	job_report() : index(1), model(0), docked(false), num_modes(0), best_energy(max_fl) {}
+};
+
+enum report_format { REPORT_JSON, REPORT_CSV };
+
+report_format report_format_from_name(const path& name);
+void write_report_header(std::ostream& out, report_format format); // nothing for JSON
+void write_report(std::ostream& out, report_format format, const job_report& r); // flushes it, as one chunk
+
+#endif
@@ -0,0 +1,108 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <cstring> // memcpy, memcmp
+#include "ligand_archive.h"
+
+namespace {
+	const char archive_magic[8] = {'V', 'I', 'N', 'A', 'L', 'I', 'B', '\n'};
+	const boost::uint32_t archive_version = 1;
+
+	struct archive_header {
+		char magic[8];
+		boost::uint32_t version;
+		boost::uint16_t fl_size;
+		boost::uint16_t sz_size;
+		boost::uint64_t count;
+		boost::uint64_t index_offset; // 0 until the index is written
+		archive_header(boost::uint64_t count_, boost::uint64_t index_offset_) : version(archive_version), fl_size(sizeof(fl)), sz_size(sizeof(sz)), count(count_), index_offset(index_offset_) {
+			std::memcpy(magic, archive_magic, sizeof(magic));
+		}
+	};
+
+	void write_header(std::ostream& out, boost::uint64_t count, boost::uint64_t index_offset) {
+		const archive_header h(count, index_offset);
+		out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	}
+}
+
+bool is_ligand_archive(const char* begin, const char* end) {
+	return sz(end - begin) >= sizeof(archive_magic) && std::memcmp(begin, archive_magic, sizeof(archive_magic)) == 0;
+}
+
+ligand_archive_writer::ligand_archive_writer(const path& name_) : name(name_), out(name_, std::ios::binary) {
+	write_header(out, 0, 0);
+}
+
+void ligand_archive_writer::add(const model& m) {
+	offsets.push_back(out.tellp());
+	std::string tmp;
+	flat_oarchive ar(tmp);
+	ar & m;
+	out.write(tmp.data(), tmp.size());
+	if(!out)
+		throw file_error(name, false);
+}
+
+void ligand_archive_writer::finish() {
+	const boost::uint64_t index_offset = out.tellp();
+	offsets.push_back(index_offset); // the end of the last entry
+	out.write(reinterpret_cast<const char*>(&offsets[0]), offsets.size() * sizeof(boost::uint64_t));
+	offsets.pop_back();
+	out.seekp(0);
+	write_header(out, offsets.size(), index_offset);
+	out.close();
+	if(!out)
+		throw file_error(name, false);
+}
+
+ligand_archive_reader::ligand_archive_reader(const path& name_, const char* begin_, const char* end) : name(name_), begin(begin_) {
+	const boost::uint64_t size = end - begin;
+	if(size < sizeof(archive_header) || !is_ligand_archive(begin, end))
+		throw archive_error(name, "not a ligand archive");
+	archive_header h(0, 0);
+	std::memcpy(&h, begin, sizeof(h)); // the mapping need not be aligned for it
+	if(h.version != archive_version || h.fl_size != sizeof(fl) || h.sz_size != sizeof(sz))
+		throw archive_error(name, "written by a different version of vina_prepare, or on a different kind of machine");
+	if(h.index_offset == 0)
+		throw archive_error(name, "incomplete - vina_prepare did not finish writing it");
+	if(h.index_offset > size || h.count >= (size - h.index_offset) / sizeof(boost::uint64_t))
+		throw archive_error(name, "the index is truncated");
+	offsets.resize(sz(h.count) + 1);
+	std::memcpy(&offsets[0], begin + h.index_offset, offsets.size() * sizeof(boost::uint64_t));
+	if(offsets.front() < sizeof(archive_header) || offsets.back() != h.index_offset)
+		throw archive_error(name, "the index is corrupt");
+	VINA_FOR(i, h.count)
+		if(offsets[i] > offsets[i+1])
+			throw archive_error(name, "the index is corrupt");
+}
+
+model ligand_archive_reader::get(sz i) const {
+	VINA_CHECK(i < size());
+	try {
+		flat_iarchive ar(begin + offsets[i], begin + offsets[i+1]);
+		return ar.load_model();
+	}
+	catch(flat_archive_error&) {
+		throw archive_error(name, "ligand " + to_string(i+1) + " is corrupt");
+	}
+}
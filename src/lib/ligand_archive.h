@@ -0,0 +1,61 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_LIGAND_ARCHIVE_H
+#define VINA_LIGAND_ARCHIVE_H
+
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/utility.hpp> // for noncopyable 
+#include "flat_archive.h"
+#include "file.h"
+
+// a precompiled ligand library (vina_prepare): the single-ligand models returned by parse_ligand_pdbqt,
+// bonds, types and interacting pairs included, serialized one after another and followed by an index of byte offsets
+// the encoding is native (byte order, sizeof(fl)), so an archive is read back only on the kind of machine that wrote it
+
+bool is_ligand_archive(const char* begin, const char* end); // from the magic bytes
+
+class ligand_archive_writer : boost::noncopyable {
+public:
+	ligand_archive_writer(const path& name); // can throw file_error
+	void add(const model& m);
+	sz size() const { return offsets.size(); }
+	void finish(); // writes the index; until then, the archive is rejected as incomplete
+private:
+	path name;
+	ofile out;
+	std::vector<boost::uint64_t> offsets;
+};
+
+class ligand_archive_reader : boost::noncopyable { // [begin, end) has to outlive the reader, e.g. a mapped_file
+public:
+	ligand_archive_reader(const path& name, const char* begin, const char* end); // can throw archive_error
+	sz size() const { return offsets.size() - 1; }
+	model get(sz i) const; // can throw archive_error
+private:
+	path name;
+	const char* begin;
+	std::vector<boost::uint64_t> offsets; // one past the last entry included
+};
+
+#endif
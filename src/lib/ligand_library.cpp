@@ -0,0 +1,183 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <cctype> // isspace
+#include <algorithm> // min
+#include <cstring> // memchr, memcmp
+#include "ligand_library.h"
+#include "parse_error.h"
+
+namespace {
+	sz count_models(const char* begin, const char* end) { // the lines that start with MODEL, as index_multimodel_pdbqt takes them
+		sz tmp = 0;
+		while(begin < end) {
+			if(end - begin >= 5 && std::memcmp(begin, "MODEL", 5) == 0)
+				++tmp;
+			const char* nl = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+			if(!nl) break;
+			begin = nl + 1;
+		}
+		return tmp;
+	}
+}
+
+ligand_library::ligand_library(const path& name_, sz slice_, sz num_slices_)
+	: name(name_), slice(slice_), num_slices(num_slices_), current(0), models_before(0), archive_begin(0), archive_end(0), models_read(0), lines_read(0), tag_line(0) {
+	VINA_CHECK(slice < num_slices);
+	if(detect_compression(name) != COMPRESSION_NONE)
+		stream.reset(new izfile(name));
+	else {
+		file.reset(new mapped_file(name));
+		if(is_ligand_archive(file->data(), file->end())) {
+			archive.reset(new ligand_archive_reader(name, file->data(), file->end()));
+			archive_begin = archive->size() *  slice      / num_slices;
+			archive_end   = archive->size() * (slice + 1) / num_slices;
+		}
+		else {
+			spans = index_multimodel_pdbqt(name, file->data(), file->end(), slice, num_slices);
+			if(!spans.empty())
+				models_before = count_models(file->data(), file->data() + spans.front().tag);
+		}
+		current = size().get(); // before the first
+	}
+}
+
+boost::optional<sz> ligand_library::size() const {
+	if(archive)
+		return archive_end - archive_begin;
+	if(file)
+		return spans.size();
+	return boost::optional<sz>();
+}
+
+bool ligand_library::next() {
+	if(stream)
+		return next_streamed();
+	const sz n = size().get();
+	current = (current == n) ? 0 : current + 1;
+	if(current < n)
+		return true;
+	current = n + 1; // stays past the end
+	return false;
+}
+
+model ligand_library::parse() const {
+	if(archive) {
+		VINA_CHECK(current < archive_end - archive_begin);
+		return archive->get(archive_begin + current);
+	}
+	if(file) {
+		VINA_CHECK(current < spans.size());
+		return parse_ligand_pdbqt(name, file->data(), spans[current]);
+	}
+	try {
+		return parse_ligand_pdbqt(name, contents.data(), contents.data() + contents.size(), tag);
+	}
+	catch(parse_error& e) {
+		e.line += tag_line;
+		throw;
+	}
+}
+
+sz ligand_library::model_number() const {
+	if(archive) {
+		VINA_CHECK(current < archive_end - archive_begin);
+		return archive_begin + current + 1;
+	}
+	if(file) {
+		VINA_CHECK(current < spans.size());
+		return models_before + current + 1;
+	}
+	return models_read;
+}
+
+std::string ligand_library::model_tag() const {
+	if(archive)
+		return ""; // not kept in the archive's index
+	std::string line = tag;
+	if(file) {
+		VINA_CHECK(current < spans.size());
+		line.assign(file->data() + spans[current].tag, file->data() + spans[current].begin);
+	}
+	sz end = line.size();
+	sz begin = (std::min)(sz(5), end); // after "MODEL"
+	while(begin < end && std::isspace(line[begin]))
+		++begin;
+	while(end > begin && std::isspace(line[end - 1]))
+		--end;
+	return line.substr(begin, end - begin);
+}
+
+namespace {
+	bool blank(const std::string& str) {
+		VINA_FOR_IN(i, str)
+			if(!std::isspace(str[i]))
+				return false;
+		return true;
+	}
+}
+
+bool ligand_library::next_streamed() { // the same framing rules as index_multimodel_pdbqt
+	std::string str;
+	while(true) {
+		bool found = false;
+		while(std::getline(*stream, str)) {
+			++lines_read;
+			if(starts_with(str, "MODEL")) {
+				found = true;
+				break;
+			}
+			else if(starts_with(str, "ENDMDL"))
+				throw parse_error(name, lines_read, "Misplaced ENDMDL tag");
+			else if(!blank(str))
+				throw parse_error(name, lines_read, "Input occurs outside MODEL");
+		}
+		if(!found) {
+			if(stream->bad())
+				throw compression_error(name, "the file ends prematurely or is corrupt");
+			return false;
+		}
+		tag = str;
+		tag_line = lines_read;
+		contents.clear();
+		bool ended = false;
+		while(std::getline(*stream, str)) {
+			++lines_read;
+			if(starts_with(str, "ENDMDL")) {
+				ended = true;
+				break;
+			}
+			if(starts_with(str, "MODEL"))
+				throw parse_error(name, lines_read, "Misplaced MODEL tag");
+			contents += str;
+			contents += '\n';
+		}
+		if(!ended) {
+			if(stream->bad())
+				throw compression_error(name, "the file ends prematurely or is corrupt");
+			throw parse_error(name, lines_read + 1, "Missing ENDMDL tag");
+		}
+		++models_read;
+		if((models_read - 1) % num_slices == slice)
+			return true;
+	}
+}
@@ -0,0 +1,75 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_LIGAND_LIBRARY_H
+#define VINA_LIGAND_LIBRARY_H
+
+#include <boost/optional.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/utility.hpp> // for noncopyable 
+#include "parse_pdbqt.h"
+#include "mapped_file.h"
+#include "compressed_file.h"
+#include "ligand_archive.h"
+
+// the ligands of a multi-MODEL PDBQT library, one at a time
+// plain files are mapped and indexed by byte offset, and a slice is a byte range (see index_multimodel_pdbqt);
+// compressed files are decompressed as they are read, and slice k of n is every n-th MODEL, starting with the k-th;
+// precompiled libraries (see ligand_archive.h) are mapped and recognized by their magic bytes, and a slice is a run of ligands
+class ligand_library : boost::noncopyable {
+public:
+	ligand_library(const path& name, sz slice, sz num_slices); // 0 <= slice < num_slices; can throw file_error, compression_error, parse_error, archive_error
+	boost::optional<sz> size() const; // known in advance only for uncompressed files
+	bool next();          // moves on to the next ligand of the slice, false at the end; can throw parse_error if the MODEL framing is broken
+	model parse() const;  // the current ligand; can throw parse_error, which affects only this ligand, or archive_error
+	// which molecule the current ligand is, the same whichever slice has it: its MODEL, 1-based, in the whole library
+	// (for precompiled ones, its entry in the archive), and what its MODEL line says after the keyword, such as a name (empty for precompiled ones)
+	sz model_number() const;
+	std::string model_tag() const;
+private:
+	path name;
+	sz slice;
+	sz num_slices;
+
+	// plain
+	boost::scoped_ptr<mapped_file> file;
+	pdbqt_model_spans spans;
+	sz current;
+	sz models_before; // the slice, in the whole file
+
+	// precompiled
+	boost::scoped_ptr<ligand_archive_reader> archive;
+	sz archive_begin;
+	sz archive_end;
+
+	// compressed
+	boost::scoped_ptr<izfile> stream;
+	sz models_read;
+	unsigned lines_read;
+	std::string tag;
+	unsigned tag_line;
+	std::string contents;
+
+	bool next_streamed();
+};
+
+#endif
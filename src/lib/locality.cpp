@@ -0,0 +1,169 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <boost/ptr_container/ptr_vector.hpp>
+#include "locality.h"
+
+#ifdef VINA_NUMA
+#include <numa.h>
+#include <numaif.h> // get_mempolicy
+#include <sched.h>  // sched_getcpu
+
+namespace {
+	bool numa_usable() {
+		static const bool tmp = (numa_available() >= 0);
+		return tmp;
+	}
+
+	szv node_cpus(sz node) { // that this process may run on
+		szv tmp;
+		struct bitmask* cpus = numa_allocate_cpumask();
+		if(numa_node_to_cpus(int(node), cpus) == 0)
+			VINA_FOR(i, cpus->size)
+				if(numa_bitmask_isbitset(cpus, unsigned(i)) && numa_bitmask_isbitset(numa_all_cpus_ptr, unsigned(i)))
+					tmp.push_back(i);
+		numa_free_cpumask(cpus);
+		return tmp;
+	}
+
+	void pin_to_cpu(sz cpu) {
+		struct bitmask* mask = numa_allocate_cpumask();
+		numa_bitmask_setbit(mask, unsigned(cpu));
+		numa_sched_setaffinity(0, mask); // the calling thread; if it fails, the thread goes on unpinned
+		numa_free_cpumask(mask);
+	}
+}
+#endif
+
+sz numa_nodes() {
+#ifdef VINA_NUMA
+	if(numa_usable())
+		return sz(numa_max_node()) + 1;
+#endif
+	return 1;
+}
+
+sz numa_node() {
+#ifdef VINA_NUMA
+	if(numa_usable()) {
+		const int cpu = sched_getcpu();
+		const int node = (cpu < 0) ? -1 : numa_node_of_cpu(cpu);
+		if(node >= 0)
+			return sz(node);
+	}
+#endif
+	return 0;
+}
+
+sz numa_node_of(const void* p) {
+	if(!p)
+		return max_sz;
+#ifdef VINA_NUMA
+	if(numa_usable()) {
+		int node = -1;
+		if(get_mempolicy(&node, NULL, 0, const_cast<void*>(p), MPOL_F_NODE | MPOL_F_ADDR) != 0 || node < 0)
+			return max_sz;
+		return sz(node);
+	}
+#endif
+	return 0;
+}
+
+sz thread_placement::place() {
+#ifdef VINA_NUMA
+	if(pin && numa_usable()) {
+		boost::mutex::scoped_lock self_lk(self);
+		const boost::thread::id id = boost::this_thread::get_id();
+		VINA_FOR_IN(i, placed)
+			if(placed[i] == id)
+				return numa_node();
+		const sz k = placed.size();
+		placed.push_back(id);
+		const sz nodes = numa_nodes();
+		VINA_FOR(i, nodes) { // the k-th thread goes to node k % nodes, skipping the nodes without CPUs
+			const szv cpus = node_cpus((k + i) % nodes);
+			if(!cpus.empty()) {
+				pin_to_cpu(cpus[(k / nodes) % cpus.size()]);
+				break;
+			}
+		}
+	}
+#endif
+	return numa_node();
+}
+
+#ifdef VINA_NUMA
+namespace {
+	struct copy_on_node {
+		const igrid* original;
+		sz node;
+		igrid** copy;
+		copy_on_node(const igrid* original_, sz node_, igrid** copy_) : original(original_), node(node_), copy(copy_) {}
+		void operator()() const {
+			numa_run_on_node(int(node));
+			numa_set_localalloc();
+			*copy = original->replicate();
+		}
+	};
+}
+#endif
+
+node_grids::node_grids(const igrid& original_, bool replicate) : original(&original_), copies(numa_nodes(), NULL) {
+#ifdef VINA_NUMA
+	if(!replicate || copies.size() < 2 || !numa_usable())
+		return;
+	const sz home = numa_node_of(original->tables());
+	if(home == max_sz) // nothing to copy
+		return;
+	boost::ptr_vector<boost::thread> threads; // one per node, all at once
+	VINA_FOR_IN(i, copies)
+		if(i != home && !node_cpus(i).empty())
+			threads.push_back(new boost::thread(copy_on_node(original, i, &copies[i])));
+	VINA_FOR_IN(i, threads)
+		threads[i].join();
+#endif
+}
+
+node_grids::~node_grids() {
+	VINA_FOR_IN(i, copies)
+		delete copies[i];
+}
+
+const igrid& node_grids::on(sz node) const {
+	if(node < copies.size() && copies[node])
+		return *copies[node];
+	return *original;
+}
+
+numa_interleaving::numa_interleaving(bool on_) : on(on_) {
+#ifdef VINA_NUMA
+	if(on && numa_usable())
+		numa_set_interleave_mask(numa_all_nodes_ptr);
+#endif
+}
+
+numa_interleaving::~numa_interleaving() {
+#ifdef VINA_NUMA
+	if(on && numa_usable())
+		numa_set_localalloc();
+#endif
+}
@@ -0,0 +1,80 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_LOCALITY_H
+#define VINA_LOCALITY_H
+
+#include <vector>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/utility.hpp> // for noncopyable
+#include "igrid.h"
+
+// on machines with several NUMA nodes, the grids are read by every search thread from wherever the thread that populated them
+// had its memory; with VINA_NUMA defined (see makefile_common), the search threads can be pinned, spread evenly over the nodes,
+// and the grids copied onto every node, or interleaved across them; without it, there is one node and nothing is moved
+
+#ifdef VINA_NUMA
+const bool numa_compiled = true;
+#else
+const bool numa_compiled = false;
+#endif
+
+enum numa_grids { NUMA_FIRST_TOUCH, NUMA_REPLICATE, NUMA_INTERLEAVE };
+
+struct numa_settings {
+	bool pin_threads;
+	numa_grids grids;
+	numa_settings() : pin_threads(false), grids(NUMA_FIRST_TOUCH) {}
+};
+
+sz numa_nodes();                // 1 if not known
+sz numa_node();                 // of the CPU the calling thread is on, 0 if not known
+sz numa_node_of(const void* p); // of the page p is in, max_sz if not known (or not touched yet)
+
+struct thread_placement : private boost::noncopyable { // pins each thread that calls place() to a CPU of its own, going round the nodes in the order the threads come
+	thread_placement(bool pin_) : pin(pin_) {}
+	sz place(); // the node the calling thread is on
+private:
+	bool pin;
+	boost::mutex self;
+	std::vector<boost::thread::id> placed;
+};
+
+struct node_grids : private boost::noncopyable { // copies of a grid, each made by a thread running on its node, so that the memory is there too
+	node_grids(const igrid& original_, bool replicate); // only grids that can be replicated are, on the nodes other than their own
+	~node_grids();
+	const igrid& on(sz node) const; // the copy on the node, or the original
+	bool of(const igrid& g) const { return original == &g; }
+private:
+	const igrid* original;
+	std::vector<igrid*> copies; // by node, NULL where there is none
+};
+
+struct numa_interleaving : private boost::noncopyable { // meanwhile, the memory the calling thread touches first is spread over all the nodes
+	numa_interleaving(bool on_);
+	~numa_interleaving();
+private:
+	bool on;
+};
+
+#endif
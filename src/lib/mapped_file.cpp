@@ -0,0 +1,123 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifdef WIN32
+#include <iterator> // istreambuf_iterator
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include "mapped_file.h"
+#include "compressed_file.h"
+#include "file.h"
+
+void mapped_file::decompress_if_needed(const path& name) {
+	const compression_format format = detect_compression(m_data, m_data + m_size);
+	if(format == COMPRESSION_NONE) return;
+	std::vector<char> tmp;
+	decompress(name, format, m_data, m_data + m_size, tmp);
+	unmap();
+	m_buffer.swap(tmp);
+	m_size = m_buffer.size();
+	m_data = m_size > 0 ? &m_buffer[0] : NULL;
+}
+
+#ifdef WIN32
+
+mapped_file::mapped_file(const path& name) : m_data(NULL), m_size(0), m_mapped(false) {
+	ifile in(name, std::ios::binary);
+	m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	if(in.bad()) throw file_error(name, true);
+	m_size = m_buffer.size();
+	m_data = m_size > 0 ? &m_buffer[0] : NULL;
+	decompress_if_needed(name);
+}
+
+mapped_file::~mapped_file() {}
+
+void mapped_file::unmap() {}
+
+#else
+
+namespace {
+	bool read_all(int fd, std::vector<char>& buffer) { // for pipes and anything else mmap refuses
+		char chunk[65536];
+		while(true) {
+			ssize_t n = ::read(fd, chunk, sizeof(chunk));
+			if(n == 0) return true;
+			if(n < 0) {
+				if(errno == EINTR) continue;
+				return false;
+			}
+			buffer.insert(buffer.end(), chunk, chunk + n);
+		}
+	}
+}
+
+mapped_file::mapped_file(const path& name) : m_data(NULL), m_size(0), m_mapped(false) {
+	int fd = ::open(name.string().c_str(), O_RDONLY);
+	if(fd < 0) throw file_error(name, true);
+	struct stat st;
+	if(::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void* p = ::mmap(NULL, sz(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if(p != MAP_FAILED) {
+			::madvise(p, sz(st.st_size), MADV_SEQUENTIAL);
+			m_data = static_cast<const char*>(p);
+			m_size = sz(st.st_size);
+			m_mapped = true;
+		}
+	}
+	if(!m_mapped) {
+		if(!read_all(fd, m_buffer)) {
+			::close(fd);
+			throw file_error(name, true);
+		}
+		m_size = m_buffer.size();
+		m_data = m_size > 0 ? &m_buffer[0] : NULL;
+	}
+	::close(fd);
+	try {
+		decompress_if_needed(name);
+	}
+	catch(...) {
+		unmap();
+		throw;
+	}
+}
+
+mapped_file::~mapped_file() {
+	unmap();
+}
+
+void mapped_file::unmap() {
+	if(m_mapped) {
+		::munmap(const_cast<char*>(m_data), m_size);
+		m_mapped = false;
+	}
+}
+
+#endif
@@ -0,0 +1,48 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_MAPPED_FILE_H
+#define VINA_MAPPED_FILE_H
+
+#include <vector>
+#include <boost/utility.hpp> // for noncopyable 
+#include "common.h"
+
+// read-only view of a whole file: memory-mapped where possible, otherwise (pipes, WIN32) read into a buffer
+// compressed files (see compressed_file.h) are decompressed into the buffer
+class mapped_file : boost::noncopyable {
+public:
+	mapped_file(const path& name); // can throw file_error, compression_error
+	~mapped_file();
+	const char* data() const { return m_data; }
+	const char* end()  const { return m_data + m_size; }
+	sz size() const { return m_size; }
+private:
+	void decompress_if_needed(const path& name);
+	void unmap();
+	const char* m_data;
+	sz m_size;
+	bool m_mapped;
+	std::vector<char> m_buffer;
+};
+
+#endif
@@ -23,6 +23,9 @@
 #include "model.h"
 #include "file.h"
 #include "curl.h"
+#include "coords.h" // rmsd_lower_bound
+#include "parallel.h" // bond perception
+#include "instrument.h"
 
 template<typename T>
 atom_range get_atom_range(const T& t) {
@@ -290,87 +293,211 @@ bool model::atom_exists_between(const distance_type_matrix& mobility, const atom
 	return false;
 }
 
-struct beads {
-	fl radius_sqr;
-	std::vector<std::pair<vec, szv> > data;
-	beads(sz reserve_size, fl radius_sqr_) : radius_sqr(radius_sqr_) { data.reserve(reserve_size); }
-	void add(sz index, const vec& coords) {
-		VINA_FOR_IN(i, data) {
-			if(vec_distance_sqr(coords, data[i].first) < radius_sqr) {
-				data[i].second.push_back(index);
-				return;
+struct cell_grid { // cubic cells over a bounding box; neighbouring cells are found by index arithmetic
+	vec origin;
+	fl cell_size;
+	sz dims[3];
+	cell_grid(const vecv& coords, fl min_cell_size, sz max_cells) : origin(0, 0, 0), cell_size(min_cell_size) {
+		vec corner(0, 0, 0);
+		if(!coords.empty()) {
+			origin = corner = coords.front();
+			VINA_FOR_IN(i, coords)
+				VINA_FOR(d, 3) {
+					if(coords[i][d] < origin[d]) origin[d] = coords[i][d];
+					if(coords[i][d] > corner[d]) corner[d] = coords[i][d];
+				}
+		}
+		while(true) { // sparse, far-flung atoms should not cost memory
+			sz n = 1;
+			VINA_FOR(d, 3) {
+				dims[d] = sz((corner[d] - origin[d]) / cell_size) + 1;
+				n *= dims[d];
 			}
+			if(n <= max_cells) break;
+			cell_size *= 2;
 		}
-		// not found
-		std::pair<vec, szv> tmp;
-		tmp.first = coords;
-		tmp.second.push_back(index);
-		data.push_back(tmp);
+	}
+	sz size() const { return dims[0] * dims[1] * dims[2]; }
+	sz coordinate(const vec& v, sz d) const {
+		const fl x = (v[d] - origin[d]) / cell_size;
+		if(x <= 0) return 0;
+		return (std::min)(sz(x), dims[d] - 1);
+	}
+	sz cell(const vec& v) const {
+		return coordinate(v, 0) + dims[0] * (coordinate(v, 1) + dims[1] * coordinate(v, 2));
+	}
+	void neighbours(const vec& v, szv& out) const { // the cell of v and the ones around it - everything within cell_size of v
+		out.clear();
+		sz c[3];
+		VINA_FOR(d, 3)
+			c[d] = coordinate(v, d);
+		VINA_RANGE(z, (c[2] > 0 ? c[2] - 1 : 0), (std::min)(c[2] + 2, dims[2]))
+			VINA_RANGE(y, (c[1] > 0 ? c[1] - 1 : 0), (std::min)(c[1] + 2, dims[1]))
+				VINA_RANGE(x, (c[0] > 0 ? c[0] - 1 : 0), (std::min)(c[0] + 2, dims[0]))
+					out.push_back(x + dims[0] * (y + dims[1] * z));
 	}
 };
 
-void model::assign_bonds(const distance_type_matrix& mobility) { // assign bonds based on relative mobility, distance and covalent length
-	const fl bond_length_allowance_factor = 1.1;
-	sz n = grid_atoms.size() + atoms.size();
+struct atom_cells { // the atoms of each cell, sorted by cell
+	cell_grid grid;
+	szv start; // of the cell in indices, one past the last cell included
+	szv indices;
+	atom_cells(const vecv& coords, fl min_cell_size) : grid(coords, min_cell_size, 8 * coords.size() + 1), start(grid.size() + 1, 0), indices(coords.size()) {
+		szv cells(coords.size());
+		VINA_FOR_IN(i, coords) {
+			cells[i] = grid.cell(coords[i]);
+			++start[cells[i] + 1];
+		}
+		VINA_FOR(i, grid.size())
+			start[i + 1] += start[i];
+		szv next(start.begin(), start.end() - 1);
+		VINA_FOR_IN(i, coords)
+			indices[next[cells[i]]++] = i;
+	}
+};
 
-	// construct beads
+// the bonds used to be found by scanning a list of 15 A beads, and their order follows it; bonded_to depends on that order,
+// so the bead each atom would have joined - the first one centered within the radius - is still worked out, with a grid
+szv bead_numbers(const vecv& coords) {
 	const fl bead_radius = 15;
-	beads beads_instance(n, sqr(bead_radius));
-	VINA_FOR(i, n) {
-		atom_index i_atom_index = sz_to_atom_index(i);
-		beads_instance.add(i, atom_coords(i_atom_index));
+	const fl radius_sqr = sqr(bead_radius);
+	const cell_grid grid(coords, bead_radius, coords.size() + 1);
+	std::vector<szv> beads_in_cells(grid.size());
+	vecv centers;
+	szv tmp(coords.size());
+	szv cells;
+	VINA_FOR_IN(i, coords) {
+		grid.neighbours(coords[i], cells);
+		sz found = max_sz;
+		VINA_FOR_IN(k, cells) {
+			const szv& beads = beads_in_cells[cells[k]];
+			VINA_FOR_IN(b, beads)
+				if(beads[b] < found && vec_distance_sqr(coords[i], centers[beads[b]]) < radius_sqr)
+					found = beads[b];
+		}
+		if(found == max_sz) {
+			found = centers.size();
+			centers.push_back(coords[i]);
+			beads_in_cells[grid.cell(coords[i])].push_back(found);
+		}
+		tmp[i] = found;
 	}
-	// assign bonds
-	VINA_FOR(i, n) {
+	return tmp;
+}
+
+struct bead_order {
+	const szv& beads;
+	bead_order(const szv& beads_) : beads(beads_) {}
+	bool operator()(sz a, sz b) const {
+		if(beads[a] != beads[b]) return beads[a] < beads[b];
+		return a < b;
+	}
+};
+
+struct found_bond {
+	sz i;
+	sz j;
+	fl length;
+	bool rotatable;
+	found_bond(sz i_, sz j_, fl length_, bool rotatable_) : i(i_), j(j_), length(length_), rotatable(rotatable_) {}
+};
+typedef std::vector<found_bond> found_bonds;
+
+struct bond_finder { // finds the bonds of a range of atoms to higher-numbered ones; ranges are independent of each other
+	const model& m;
+	const distance_type_matrix& mobility;
+	const vecv& coords;
+	const atom_cells& cells;
+	const szv& beads;
+	sz num_ranges;
+	std::vector<found_bonds>& out; // one per range
+	bond_finder(const model& m_, const distance_type_matrix& mobility_, const vecv& coords_, const atom_cells& cells_, const szv& beads_, sz num_ranges_, std::vector<found_bonds>& out_)
+		: m(m_), mobility(mobility_), coords(coords_), cells(cells_), beads(beads_), num_ranges(num_ranges_), out(out_) {}
+	void operator()(sz range) const {
+		m.find_bonds(mobility, coords, cells, beads, coords.size() * range / num_ranges, coords.size() * (range + 1) / num_ranges, out[range]);
+	}
+};
+
+void model::find_bonds(const distance_type_matrix& mobility, const vecv& all_coords, const atom_cells& cells, const szv& beads, sz begin, sz end, found_bonds& out) const {
+	const fl bond_length_allowance_factor = 1.1;
+	const fl max_covalent_r = max_covalent_radius(); // FIXME mv to atom_constants
+	szv neighbour_cells;
+	szv relevant_atoms;
+	VINA_RANGE(i, begin, end) {
 		atom_index i_atom_index = sz_to_atom_index(i);
-		const vec& i_atom_coords = atom_coords(i_atom_index);
-		atom& i_atom = get_atom(i_atom_index);
+		const vec& i_atom_coords = all_coords[i];
+		const atom& i_atom = get_atom(i_atom_index);
 
-		const fl max_covalent_r = max_covalent_radius(); // FIXME mv to atom_constants
 		fl i_atom_covalent_radius = max_covalent_r;
 		if(i_atom.ad < AD_TYPE_SIZE)
 			i_atom_covalent_radius = ad_type_property(i_atom.ad).covalent_radius;
 
 		//find relevant atoms
-		szv relevant_atoms;
-		const fl bead_cutoff_sqr = sqr(bead_radius + bond_length_allowance_factor * (i_atom_covalent_radius + max_covalent_r));
-		VINA_FOR_IN(b, beads_instance.data) {
-			if(vec_distance_sqr(beads_instance.data[b].first, i_atom_coords) > bead_cutoff_sqr) continue;
-			const szv& bead_elements = beads_instance.data[b].second;
-			VINA_FOR_IN(bead_elements_i, bead_elements) {
-				sz j = bead_elements[bead_elements_i];
+		relevant_atoms.clear();
+		const fl relevant_cutoff_sqr = sqr(bond_length_allowance_factor * (i_atom_covalent_radius + max_covalent_r));
+		cells.grid.neighbours(i_atom_coords, neighbour_cells);
+		VINA_FOR_IN(k, neighbour_cells) {
+			const sz cell = neighbour_cells[k];
+			VINA_RANGE(p, cells.start[cell], cells.start[cell + 1]) {
+				sz j = cells.indices[p];
+				if(i == j) continue;
 				atom_index j_atom_index = sz_to_atom_index(j);
-				atom& j_atom = get_atom(j_atom_index);
-				const fl bond_length = i_atom.optimal_covalent_bond_length(j_atom);
 				distance_type dt = distance_type_between(mobility, i_atom_index, j_atom_index);
-				if(dt != DISTANCE_VARIABLE && i != j) {
-					fl r2 = distance_sqr_between(i_atom_index, j_atom_index);
-					//if(r2 < sqr(bond_length_allowance_factor * bond_length))
-					if(r2 < sqr(bond_length_allowance_factor * (i_atom_covalent_radius + max_covalent_r)))
-						relevant_atoms.push_back(j);
-				}
+				if(dt != DISTANCE_VARIABLE && vec_distance_sqr(i_atom_coords, all_coords[j]) < relevant_cutoff_sqr)
+					relevant_atoms.push_back(j);
 			}
 		}
+		std::sort(relevant_atoms.begin(), relevant_atoms.end(), bead_order(beads));
+
 		// find bonded atoms
 		VINA_FOR_IN(relevant_atoms_i, relevant_atoms) {
 			sz j = relevant_atoms[relevant_atoms_i];
 			if(j <= i) continue; // already considered
 			atom_index j_atom_index = sz_to_atom_index(j);
-			atom& j_atom = get_atom(j_atom_index);
+			const atom& j_atom = get_atom(j_atom_index);
 			const fl bond_length = i_atom.optimal_covalent_bond_length(j_atom);
 			distance_type dt = distance_type_between(mobility, i_atom_index, j_atom_index);
 			fl r2 = distance_sqr_between(i_atom_index, j_atom_index);
-			if(r2 < sqr(bond_length_allowance_factor * bond_length) && !atom_exists_between(mobility, i_atom_index, j_atom_index, relevant_atoms)) {
-				bool rotatable = (dt == DISTANCE_ROTOR);
-				fl length = std::sqrt(r2);
-				i_atom.bonds.push_back(bond(j_atom_index, length, rotatable));
-				j_atom.bonds.push_back(bond(i_atom_index, length, rotatable));
-			}
-
+			if(r2 < sqr(bond_length_allowance_factor * bond_length) && !atom_exists_between(mobility, i_atom_index, j_atom_index, relevant_atoms))
+				out.push_back(found_bond(i, j, std::sqrt(r2), dt == DISTANCE_ROTOR));
 		}
 	}
 }
 
+void model::assign_bonds(const distance_type_matrix& mobility, sz num_threads) { // assign bonds based on relative mobility, distance and covalent length
+	const fl bond_length_allowance_factor = 1.1;
+	const sz n = grid_atoms.size() + atoms.size();
+	vecv all_coords(n);
+	VINA_FOR(i, n)
+		all_coords[i] = atom_coords(sz_to_atom_index(i));
+
+	const atom_cells cells(all_coords, bond_length_allowance_factor * 2 * max_covalent_radius()); // the longest a bond can be
+	const szv beads = bead_numbers(all_coords);
+
+	// receptors are large enough to be worth threads; ligands are not
+	const sz min_atoms_per_thread = 5000;
+	num_threads = (std::min)(num_threads, n / min_atoms_per_thread);
+	std::vector<found_bonds> found(num_threads > 1 ? 4 * num_threads : 1);
+	bond_finder finder(*this, mobility, all_coords, cells, beads, found.size(), found);
+	if(num_threads > 1) {
+		parallel_for<bond_finder> p(&finder, num_threads);
+		p.run(found.size());
+	}
+	else
+		VINA_FOR_IN(range, found)
+			finder(range);
+
+	// assign bonds, in the order they were found
+	VINA_FOR_IN(range, found)
+		VINA_FOR_IN(k, found[range]) {
+			const found_bond& b = found[range][k];
+			atom_index i_atom_index = sz_to_atom_index(b.i);
+			atom_index j_atom_index = sz_to_atom_index(b.j);
+			get_atom(i_atom_index).bonds.push_back(bond(j_atom_index, b.length, b.rotatable));
+			get_atom(j_atom_index).bonds.push_back(bond(i_atom_index, b.length, b.rotatable));
+		}
+}
+
 bool model::bonded_to_HD(const atom& a) const {
 	VINA_FOR_IN(i, a.bonds) {
 		const bond& b = a.bonds[i];
@@ -466,10 +593,10 @@ void model::initialize_pairs(const distance_type_matrix& mobility) {
 	}
 }
 
-void model::initialize(const distance_type_matrix& mobility) {
+void model::initialize(const distance_type_matrix& mobility, sz num_threads) {
 	VINA_FOR_IN(i, ligands)
 		ligands[i].set_range();
-	assign_bonds(mobility);
+	assign_bonds(mobility, num_threads);
 	assign_types();
 	initialize_pairs(mobility);
 }
@@ -557,7 +684,7 @@ std::string coords_to_pdbqt_string(const vec& coords, const std::string& str) {
 	return tmp;
 }
 
-void model::write_context(const context& c, ofile& out) const {
+void model::write_context(const context& c, std::ostream& out) const {
 	verify_bond_lengths();
 	VINA_FOR_IN(i, c) {
 		const std::string& str = c[i].first;
@@ -656,6 +783,7 @@ fl model::eval         (const precalculate& p, const igrid& ig, const vec& v, co
 }
 
 fl model::eval_deriv  (const precalculate& p, const igrid& ig, const vec& v, const conf& c, change& g) { // clean up
+	VINA_INSTRUMENT_SCOPE(INSTRUMENT_MODEL_EVAL_DERIV);
 	set(c);
 	fl e = ig.eval_deriv(*this, v[1]); // sets minus_forces, except inflex
 	e += eval_interacting_pairs_deriv(p, v[2], other_pairs, coords, minus_forces); // adds to minus_forces
@@ -717,35 +845,10 @@ fl model::eval_adjusted      (const scoring_function& sf, const precalculate& p,
 	return sf.conf_independent(*this, e - intramolecular_energy);
 }
 
-fl model::rmsd_lower_bound_asymmetric(const model& x, const model& y) const { // actually static
-	sz n = x.m_num_movable_atoms; 
-	VINA_CHECK(n == y.m_num_movable_atoms);
-	fl sum = 0;
-	unsigned counter = 0;
-	VINA_FOR(i, n) {
-		const atom& a =   x.atoms[i];
-		if(a.el != EL_TYPE_H) {
-			fl r2 = max_fl;
-			VINA_FOR(j, n) {
-				const atom& b = y.atoms[j];
-				if(a.same_element(b) && !b.is_hydrogen()) {
-					fl this_r2 = vec_distance_sqr(x.coords[i], 
-					                              y.coords[j]);
-					if(this_r2 < r2)
-						r2 = this_r2;
-				}
-			}
-			assert(not_max(r2));
-			sum += r2;
-			++counter;
-		}
-	}
-	return (counter == 0) ? 0 : std::sqrt(sum / counter);
-}
-
 fl model::rmsd_lower_bound(const model& m) const {
-	return (std::max)(rmsd_lower_bound_asymmetric(*this,     m),
-		            rmsd_lower_bound_asymmetric(    m, *this));
+	VINA_CHECK(m_num_movable_atoms == m.m_num_movable_atoms);
+	return ::rmsd_lower_bound(  get_heavy_atom_movable_coords(),   get_heavy_atom_movable_elements(),
+	                          m.get_heavy_atom_movable_coords(), m.get_heavy_atom_movable_elements());
 }
 
 fl model::rmsd_upper_bound(const model& m) const {
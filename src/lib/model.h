@@ -24,6 +24,10 @@
 #define VINA_MODEL_H
 
 #include <boost/optional.hpp> // for context
+#include <boost/serialization/version.hpp> // optional.hpp needs it first in some Boost versions
+#include <boost/serialization/optional.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/utility.hpp> // std::pair
 
 #include "file.h"
 #include "tree.h"
@@ -36,9 +40,20 @@ struct interacting_pair {
 	sz type_pair_index;
 	sz a;
 	sz b;
+	interacting_pair() : type_pair_index(0), a(0), b(0) {}
 	interacting_pair(sz type_pair_index_, sz a_, sz b_) : type_pair_index(type_pair_index_), a(a_), b(b_) {}
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & type_pair_index;
+		ar & a;
+		ar & b;
+	}
 };
 
+BOOST_IS_BITWISE_SERIALIZABLE(interacting_pair)
+
 typedef std::vector<interacting_pair> interacting_pairs;
 
 typedef std::pair<std::string, boost::optional<sz> > parsed_line;
@@ -48,12 +63,30 @@ struct ligand : public flexible_body, atom_range {
 	unsigned degrees_of_freedom; // can be different from the apparent number of rotatable bonds, because of the disabled torsions
 	interacting_pairs pairs;
 	context cont;
+	ligand() : degrees_of_freedom(0) {}
 	ligand(const flexible_body& f, unsigned degrees_of_freedom_) : flexible_body(f), atom_range(0, 0), degrees_of_freedom(degrees_of_freedom_) {}
 	void set_range();
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & boost::serialization::base_object<flexible_body>(*this);
+		ar & boost::serialization::base_object<atom_range>(*this);
+		ar & degrees_of_freedom;
+		ar & pairs;
+		ar & cont;
+	}
 };
 
 struct residue : public main_branch {
+	residue() {}
 	residue(const main_branch& m) : main_branch(m) {}
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & boost::serialization::base_object<main_branch>(*this);
+	}
 };
 
 enum distance_type {DISTANCE_FIXED, DISTANCE_ROTOR, DISTANCE_VARIABLE};
@@ -67,6 +100,10 @@ struct terms; // forward declaration
 struct conf_independent_inputs; // forward declaration
 struct pdbqt_initializer; // forward declaration - only declared in parse_pdbqt.cpp
 struct model_test;
+struct flat_iarchive; // forward declaration
+struct atom_cells; // forward declaration - only declared in model.cpp
+struct found_bond; // forward declaration - only declared in model.cpp
+struct bond_finder; // forward declaration - only declared in model.cpp
 
 struct model {
 	void append(const model& m);
@@ -90,18 +127,18 @@ struct model {
 
 	void write_flex  (                  const path& name, const std::string& remark) const { write_context(flex_context, name, remark); }
 	void write_ligand(sz ligand_number, const path& name, const std::string& remark) const { VINA_CHECK(ligand_number < ligands.size()); write_context(ligands[ligand_number].cont, name, remark); }
-	void write_structure(ofile& out) const {
+	void write_structure(std::ostream& out) const {
 		VINA_FOR_IN(i, ligands)
 			write_context(ligands[i].cont, out);
 		if(num_flex() > 0) // otherwise remark is written in vain
 			write_context(flex_context, out);
 	}
-	void write_structure(ofile& out, const std::string& remark) const {
+	void write_structure(std::ostream& out, const std::string& remark) const {
 		out << remark;
 		write_structure(out);
 	}
 	void write_structure(const path& name) const { ofile out(name); write_structure(out); }
-	void write_model(ofile& out, sz model_number, const std::string& remark) const {
+	void write_model(std::ostream& out, sz model_number, const std::string& remark) const {
 		out << "MODEL " << model_number << '\n';
 		write_structure(out, remark);
 		out << "ENDMDL\n";
@@ -162,6 +199,13 @@ struct model {
 				tmp.push_back(coords[i]);
 		return tmp;
 	}
+	szv get_heavy_atom_movable_elements() const { // in the same order as get_heavy_atom_movable_coords
+		szv tmp;
+		VINA_FOR(i, num_movable_atoms())
+			if(atoms[i].el != EL_TYPE_H)
+				tmp.push_back(atoms[i].el);
+		return tmp;
+	}
 	void check_internal_pairs() const;
 	void print_stuff() const; // FIXME rm
 
@@ -171,20 +215,24 @@ private:
 	friend struct non_cache;
 	friend struct naive_non_cache;
 	friend struct cache;
+	friend struct sparse_cache;
 	friend struct szv_grid;
 	friend struct terms;
 	friend struct conf_independent_inputs;
 	friend struct appender_info;
 	friend struct pdbqt_initializer;
+	friend struct bond_finder;
 	friend struct model_test;
+	friend struct flat_iarchive;
+	friend class boost::serialization::access;
 
 	model() : m_num_movable_atoms(0), m_atom_typing_used(atom_type::XS) {};
 
 	const atom& get_atom(const atom_index& i) const { return (i.in_grid ? grid_atoms[i.i] : atoms[i.i]); }
 	      atom& get_atom(const atom_index& i)       { return (i.in_grid ? grid_atoms[i.i] : atoms[i.i]); }
 
-	void write_context(const context& c, ofile& out) const;
-	void write_context(const context& c, ofile& out, const std::string& remark) const {
+	void write_context(const context& c, std::ostream& out) const;
+	void write_context(const context& c, std::ostream& out, const std::string& remark) const {
 		out << remark;
 	}
 	void write_context(const context& c, const path& name) const {
@@ -195,7 +243,6 @@ private:
 		ofile out(name);
 		write_context(c, out, remark);
 	}
-	fl rmsd_lower_bound_asymmetric(const model& x, const model& y) const; // actually static
 	
 	atom_index sz_to_atom_index(sz i) const; // grid_atoms, atoms
 	bool bonded_to_HD(const atom& a) const;
@@ -204,10 +251,11 @@ private:
 	void bonded_to(sz a, sz n, szv& out) const;
 	szv bonded_to(sz a, sz n) const;
 
-	void assign_bonds(const distance_type_matrix& mobility); // assign bonds based on relative mobility, distance and covalent length
+	void assign_bonds(const distance_type_matrix& mobility, sz num_threads); // assign bonds based on relative mobility, distance and covalent length
+	void find_bonds(const distance_type_matrix& mobility, const vecv& all_coords, const atom_cells& cells, const szv& beads, sz begin, sz end, std::vector<found_bond>& out) const; // of atoms [begin, end) to higher-numbered ones
 	void assign_types();
 	void initialize_pairs(const distance_type_matrix& mobility);
-	void initialize(const distance_type_matrix& mobility);
+	void initialize(const distance_type_matrix& mobility, sz num_threads); // large receptors are bonded with up to num_threads threads
 	fl clash_penalty_aux(const interacting_pairs& pairs) const;
 
 	vecv internal_coords;
@@ -223,6 +271,23 @@ private:
 
 	sz m_num_movable_atoms;
 	atom_type::t m_atom_typing_used;
+
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & internal_coords;
+		ar & coords;
+		ar & minus_forces;
+		ar & grid_atoms;
+		ar & atoms;
+		ar & ligands;
+		ar & flex;
+		ar & flex_context;
+		ar & other_pairs;
+		ar & m_num_movable_atoms;
+		ar & m_atom_typing_used;
+	}
 };
 
+fl eval_interacting_pairs_deriv(const precalculate& p, fl v, const interacting_pairs& pairs, const vecv& coords, vecv& forces); // adds to forces
+
 #endif
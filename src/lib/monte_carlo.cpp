@@ -48,7 +48,7 @@ void monte_carlo::single_run(model& m, output_type& out, const precalculate& p,
 	VINA_U_FOR(step, num_steps) {
 		output_type candidate(current.c, max_fl);
 		mutate_conf(candidate.c, m, mutation_amplitude, generator);
-		quasi_newton_par(m, p, ig, candidate, g, hunt_cap);
+		quasi_newton_par(m, p, ig.coarse(), candidate, g, hunt_cap);
 		if(step == 0 || metropolis_accept(current.e, candidate.e, temperature, generator)) {
 			quasi_newton_par(m, p, ig, candidate, g, authentic_v);
 			current = candidate;
@@ -79,36 +79,43 @@ output_type monte_carlo::many_runs(model& m, const precalculate& p, const igrid&
 
 
 // out is sorted
-void monte_carlo::operator()(model& m, output_container& out, const precalculate& p, const igrid& ig, const precalculate& p_widened, const igrid& ig_widened, const vec& corner1, const vec& corner2, incrementable* increment_me, rng& generator) const {
+void monte_carlo::operator()(model& m, output_container& out, const precalculate& p, const igrid& ig, const precalculate& p_widened, const igrid& ig_widened, const vec& corner1, const vec& corner2, incrementable* increment_me, rng& generator, search_counters* counters) const {
 	vec authentic_v(1000, 1000, 1000); // FIXME? this is here to avoid max_fl/max_fl
 	conf_size s = m.get_size();
 	change g(s);
 	output_type tmp(s, 0);
 	tmp.c.randomize(corner1, corner2, generator);
 	fl best_e = max_fl;
+	output_store store(min_rmsd, num_saved_mins); // 20 - max size
+	store.add(out);
 	quasi_newton quasi_newton_par; quasi_newton_par.max_steps = ssd_par.evals;
 	VINA_U_FOR(step, num_steps) {
 		if(increment_me)
 			++(*increment_me);
+		if(counters)
+			++counters->mc_steps;
 		output_type candidate = tmp;
 		mutate_conf(candidate.c, m, mutation_amplitude, generator);
-		quasi_newton_par(m, p, ig, candidate, g, hunt_cap);
+		quasi_newton_par(m, p, ig.coarse(), candidate, g, hunt_cap, counters);
 		if(step == 0 || metropolis_accept(tmp.e, candidate.e, temperature, generator)) {
+			if(counters)
+				++counters->mc_accepted;
 			tmp = candidate;
 
 			m.set(tmp.c); // FIXME? useless?
 
 			// FIXME only for very promising ones
-			if(tmp.e < best_e || out.size() < num_saved_mins) {
-				quasi_newton_par(m, p, ig, tmp, g, authentic_v);
+			if(tmp.e < best_e || store.size() < num_saved_mins) {
+				quasi_newton_par(m, p, ig, tmp, g, authentic_v, counters);
 				m.set(tmp.c); // FIXME? useless?
 				tmp.coords = m.get_heavy_atom_movable_coords();
-				add_to_output_container(out, tmp, min_rmsd, num_saved_mins); // 20 - max size
+				store.add(tmp);
 				if(tmp.e < best_e)
 					best_e = tmp.e;
 			}
 		}
 	}
+	store.transfer(out);
 	VINA_CHECK(!out.empty());
 	VINA_CHECK(out.front().e <= out.back().e); // make sure the sorting worked in the correct order
 }
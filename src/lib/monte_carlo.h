@@ -25,6 +25,7 @@
 
 #include "ssd.h"
 #include "incrementable.h"
+#include "search_counters.h"
 
 struct monte_carlo {
 	unsigned num_steps;
@@ -41,7 +42,7 @@ struct monte_carlo {
 
 	void single_run(model& m, output_type& out, const precalculate& p, const igrid& ig, rng& generator) const;
 	// out is sorted
-	void operator()(model& m, output_container& out, const precalculate& p, const igrid& ig, const precalculate& p_widened, const igrid& ig_widened, const vec& corner1, const vec& corner2, incrementable* increment_me, rng& generator) const;
+	void operator()(model& m, output_container& out, const precalculate& p, const igrid& ig, const precalculate& p_widened, const igrid& ig_widened, const vec& corner1, const vec& corner2, incrementable* increment_me, rng& generator, search_counters* counters = NULL) const;
 	void many_runs(model& m, output_container& out, const precalculate& p, const igrid& ig, const vec& corner1, const vec& corner2, sz num_runs, rng& generator) const;
 
 };
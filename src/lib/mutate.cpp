@@ -21,6 +21,7 @@
 */
 
 #include "mutate.h"
+#include "instrument.h"
 
 sz count_mutable_entities(const conf& c) {
 	sz counter = 0;
@@ -33,6 +34,7 @@ sz count_mutable_entities(const conf& c) {
 
 // does not set model
 void mutate_conf(conf& c, const model& m, fl amplitude, rng& generator) { // ONE OF: 2A for position, similar amp for orientation, randomize torsion
+	VINA_INSTRUMENT_SCOPE(INSTRUMENT_MUTATE_CONF);
 	sz mutable_entities_num = count_mutable_entities(c);
 	if(mutable_entities_num == 0) return;
 	int which_int = random_int(0, int(mutable_entities_num - 1), generator);
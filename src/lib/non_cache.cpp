@@ -22,6 +22,7 @@
 
 #include "non_cache.h"
 #include "curl.h"
+#include "instrument.h"
 
 non_cache::non_cache(const model& m, const grid_dims& gd_, const precalculate* p_, fl slope_) : sgrid(m, szv_grid_dims(gd_), p_->cutoff_sqr()), gd(gd_), p(p_), slope(slope_) {}
 
@@ -80,6 +81,7 @@ bool non_cache::within(const model& m, fl margin) const {
 }
 
 fl non_cache::eval_deriv(      model& m, fl v) const { // clean up
+	VINA_INSTRUMENT_SCOPE(INSTRUMENT_GRID_EVAL_DERIV);
 	fl e = 0;
 	const fl cutoff_sqr = p->cutoff_sqr();
 
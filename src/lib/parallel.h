@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "common.h"
+#include "trace.h"
 
 #include <boost/optional.hpp>
 #include <boost/thread/thread.hpp>
@@ -46,6 +47,7 @@ struct parallel_for : private boost::thread_group {
 		VINA_FOR_IN(i, thread_finished) 
 			thread_finished[i] = false;
         cond.notify_all(); // many things modified
+		trace_span join("pool", "waiting for the workers");
         while(count_finished < num_threads) // wait until processing of all elements is thread_finished
             busy.wait(self_lk);
     }
@@ -88,8 +90,11 @@ private:
 	boost::mutex self; // any modification or reading of mutables should lock this first
 	boost::optional<sz> get_size(sz offset) {
 		boost::mutex::scoped_lock self_lk(self);
-        while(!destructing && thread_finished[offset])
-            cond.wait(self_lk);
+		if(!destructing && thread_finished[offset]) {
+			trace_span idle("pool", "idle");
+			while(!destructing && thread_finished[offset])
+				cond.wait(self_lk);
+		}
 		if(destructing) return boost::optional<sz>(); // wrap it up!
         return size;
     }
@@ -108,6 +113,7 @@ struct parallel_for<F, true> : private boost::thread_group {
         finished = 0;
         started = 0;
         cond.notify_all(); // many things modified
+		trace_span join("pool", "waiting for the workers");
         while(finished < size) // wait until processing of all elements is finished
             busy.wait(self_lk);
     }
@@ -146,8 +152,11 @@ private:
 	boost::mutex self; // any modification or reading of mutables should lock this first
 	boost::optional<sz> get_next() {
 		boost::mutex::scoped_lock self_lk(self);
-        while(!destructing && started >= size)
-            cond.wait(self_lk);
+		if(!destructing && started >= size) {
+			trace_span idle("pool", "idle");
+			while(!destructing && started >= size)
+				cond.wait(self_lk);
+		}
 		if(destructing) return boost::optional<sz>(); // NOTHING
 		sz tmp = started;
         ++started;
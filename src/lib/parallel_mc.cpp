@@ -20,16 +20,27 @@
 
 */
 
+#include <algorithm> // find
+#include <boost/scoped_ptr.hpp>
 #include "parallel.h"
 #include "parallel_mc.h"
 #include "coords.h"
 #include "parallel_progress.h"
+#include "timers.h"
+#include "trace.h"
 
 struct parallel_mc_task {
 	model m;
 	output_container out;
 	rng generator;
-	parallel_mc_task(const model& m_, int seed) : m(m_), generator(static_cast<rng::result_type>(seed)) {}
+	sz index; // among the tasks of this search
+	search_counters counters;
+	instrument_counts instrument;
+	boost::thread::id thread; // that ran it
+	fl busy;                  // seconds it took
+	sz node;                  // NUMA node of the thread
+	sz grid_node;             // and of the grids it read, max_sz if not known
+	parallel_mc_task(const model& m_, int seed, sz index_) : m(m_), generator(static_cast<rng::result_type>(seed)), index(index_), busy(0), node(0), grid_node(max_sz) {}
 };
 
 typedef boost::ptr_vector<parallel_mc_task> parallel_mc_task_container;
@@ -37,40 +48,74 @@ typedef boost::ptr_vector<parallel_mc_task> parallel_mc_task_container;
 struct parallel_mc_aux {
 	const monte_carlo* mc;
 	const precalculate* p;
-	const igrid* ig;
+	const node_grids* ig;
 	const precalculate* p_widened;
-	const igrid* ig_widened;
+	const node_grids* ig_widened; // NULL if the same as ig
 	const vec* corner1;
 	const vec* corner2;
 	parallel_progress* pg;
-	parallel_mc_aux(const monte_carlo* mc_, const precalculate* p_, const igrid* ig_, const precalculate* p_widened_, const igrid* ig_widened_, const vec* corner1_, const vec* corner2_, parallel_progress* pg_)
-		: mc(mc_), p(p_), ig(ig_), p_widened(p_widened_), ig_widened(ig_widened_), corner1(corner1_), corner2(corner2_), pg(pg_) {}
+	thread_placement* placement;
+	parallel_mc_aux(const monte_carlo* mc_, const precalculate* p_, const node_grids* ig_, const precalculate* p_widened_, const node_grids* ig_widened_, const vec* corner1_, const vec* corner2_, parallel_progress* pg_, thread_placement* placement_)
+		: mc(mc_), p(p_), ig(ig_), p_widened(p_widened_), ig_widened(ig_widened_), corner1(corner1_), corner2(corner2_), pg(pg_), placement(placement_) {}
 	void operator()(parallel_mc_task& t) const {
-		(*mc)(t.m, t.out, *p, *ig, *p_widened, *ig_widened, *corner1, *corner2, pg, t.generator);
+		wall_timer timer;
+		trace_span span("search", "monte carlo task", t.index);
+		instrument_install install(&t.instrument);
+		t.thread = boost::this_thread::get_id();
+		t.node = placement->place();
+		const igrid& g = ig->on(t.node);
+		const igrid& g_widened = ig_widened ? ig_widened->on(t.node) : g;
+		t.grid_node = numa_node_of(g.tables());
+		(*mc)(t.m, t.out, *p, g, *p_widened, g_widened, *corner1, *corner2, pg, t.generator, &t.counters);
+		t.busy = timer.elapsed();
 	}
 };
 
-void merge_output_containers(const output_container& in, output_container& out, fl min_rmsd, sz max_size) {
-	VINA_FOR_IN(i, in)
-		add_to_output_container(out, in[i], min_rmsd, max_size);
-}
-
 void merge_output_containers(const parallel_mc_task_container& many, output_container& out, fl min_rmsd, sz max_size) {
 	min_rmsd = 2; // FIXME? perhaps it's necessary to separate min_rmsd during search and during output?
+	output_store store(min_rmsd, max_size);
+	store.add(out);
 	VINA_FOR_IN(i, many)
-		merge_output_containers(many[i].out, out, min_rmsd, max_size);
-	out.sort();
+		store.add(many[i].out);
+	store.transfer(out); // sorted
+}
+
+void add_stats(const parallel_mc_task_container& tasks, search_stats& stats) {
+	std::vector<boost::thread::id> threads; // in the order they first show up
+	VINA_FOR_IN(i, tasks) {
+		const parallel_mc_task& t = tasks[i];
+		stats.counters += t.counters;
+		stats.instrument += t.instrument;
+		const sz k = std::find(threads.begin(), threads.end(), t.thread) - threads.begin();
+		if(k == threads.size()) {
+			threads.push_back(t.thread);
+			stats.thread_busy.push_back(0);
+		}
+		stats.thread_busy[k] += t.busy;
+		if(t.grid_node != max_sz)
+			++(t.grid_node == t.node ? stats.local_tasks : stats.remote_tasks);
+	}
 }
 
-void parallel_mc::operator()(const model& m, output_container& out, const precalculate& p, const igrid& ig, const precalculate& p_widened, const igrid& ig_widened, const vec& corner1, const vec& corner2, rng& generator) const {
+void parallel_mc::operator()(const model& m, output_container& out, const precalculate& p, const igrid& ig, const precalculate& p_widened, const igrid& ig_widened, const vec& corner1, const vec& corner2, rng& generator, search_stats* stats) const {
 	parallel_progress pp;
-	parallel_mc_aux parallel_mc_aux_instance(&mc, &p, &ig, &p_widened, &ig_widened, &corner1, &corner2, (display_progress ? (&pp) : NULL));
+	const bool replicate = (numa.grids == NUMA_REPLICATE);
+	boost::scoped_ptr<node_grids> own_grids;
+	if(!replicas)
+		own_grids.reset(new node_grids(ig, replicate));
+	const node_grids& grids = replicas ? *replicas : *own_grids;
+	VINA_CHECK(grids.of(ig));
+	node_grids grids_widened(ig_widened, replicate && &ig_widened != &ig);
+	thread_placement placement(numa.pin_threads);
+	parallel_mc_aux parallel_mc_aux_instance(&mc, &p, &grids, &p_widened, (&ig_widened != &ig) ? &grids_widened : NULL, &corner1, &corner2, (display_progress ? (&pp) : NULL), &placement);
 	parallel_mc_task_container task_container;
 	VINA_FOR(i, num_tasks)
-		task_container.push_back(new parallel_mc_task(m, random_int(0, 1000000, generator)));
+		task_container.push_back(new parallel_mc_task(m, random_int(0, 1000000, generator), i));
 	if(display_progress) 
-		pp.init(num_tasks * mc.num_steps);
+		pp.init(num_tasks * mc.num_steps, *progress_stream);
 	parallel_iter<parallel_mc_aux, parallel_mc_task_container, parallel_mc_task, true> parallel_iter_instance(&parallel_mc_aux_instance, num_threads);
 	parallel_iter_instance.run(task_container);
 	merge_output_containers(task_container, out, mc.min_rmsd, mc.num_saved_mins);
+	if(stats)
+		add_stats(task_container, *stats);
 }
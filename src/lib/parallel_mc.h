@@ -23,15 +23,20 @@
 #ifndef VINA_PARALLEL_MC_H
 #define VINA_PARALLEL_MC_H
 
+#include <iostream>
 #include "monte_carlo.h"
+#include "locality.h"
 
 struct parallel_mc {
 	monte_carlo mc;
 	sz num_tasks;
 	sz num_threads;
 	bool display_progress;
-	parallel_mc() : num_tasks(8), num_threads(1), display_progress(true) {}
-	void operator()(const model& m, output_container& out, const precalculate& p, const igrid& ig, const precalculate& p_widened, const igrid& ig_widened, const vec& corner1, const vec& corner2, rng& generator) const;
+	std::ostream* progress_stream; // for the progress bar
+	numa_settings numa;
+	const node_grids* replicas; // of ig, kept by the caller from one search to the next; if NULL, they are made for each search, as numa says
+	parallel_mc() : num_tasks(8), num_threads(1), display_progress(true), progress_stream(&std::cout), replicas(NULL) {}
+	void operator()(const model& m, output_container& out, const precalculate& p, const igrid& ig, const precalculate& p_widened, const igrid& ig_widened, const vec& corner1, const vec& corner2, rng& generator, search_stats* stats = NULL) const;
 };
 
 #endif
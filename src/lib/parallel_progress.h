@@ -30,7 +30,7 @@
 
 struct parallel_progress : public incrementable {
 	parallel_progress() : p(NULL) {}
-	void init(unsigned long n) { p = new boost::progress_display(n); }
+	void init(unsigned long n, std::ostream& out) { p = new boost::progress_display(n, out); }
 	void operator++() {
 		if(p) {
 			boost::mutex::scoped_lock self_lk(self);
@@ -20,18 +20,58 @@
 
 */
 
-#include <fstream> // for getline ?
-#include <sstream> // in parse_two_unsigneds
 #include <cctype> // isspace
+#include <algorithm> // count
+#include <cstdlib> // strtod, strtol
+#include <cstring> // memchr, strncmp
 #include <boost/utility.hpp> // for noncopyable 
 #include <boost/optional.hpp>
-#include <boost/filesystem/fstream.hpp>
 #include <boost/lexical_cast.hpp>
 #include "parse_pdbqt.h"
 #include "atom_constants.h"
 #include "file.h"
+#include "mapped_file.h"
 #include "convert_substring.h"
 #include "parse_error.h"
+#include "brick.h"
+
+// a line of the input, pointing into the (mapped) file contents - nothing is copied until it has to be stored
+struct line_ref {
+	const char* begin;
+	sz size;
+	line_ref() : begin(NULL), size(0) {}
+	bool empty() const { return size == 0; }
+	bool blank() const {
+		VINA_FOR(i, size)
+			if(!std::isspace(begin[i]))
+				return false;
+		return true;
+	}
+	bool starts_with(const char* start) const {
+		sz n = std::strlen(start);
+		return n <= size && std::strncmp(begin, start, n) == 0;
+	}
+	std::string str() const { return std::string(begin, size); }
+	std::string substr(sz i, sz n) const { return std::string(begin + i, n); } // 0-based
+};
+
+// splits the buffer like std::getline would: the last line does not need a terminating newline
+class line_reader {
+public:
+	line_reader(const char* begin, const char* end_) : cur(begin), end(end_) {}
+	bool next(line_ref& line) {
+		if(cur == end) return false;
+		const char* nl = static_cast<const char*>(std::memchr(cur, '\n', end - cur));
+		const char* line_end = nl ? nl : end;
+		line.begin = cur;
+		line.size = line_end - cur;
+		cur = nl ? nl + 1 : end;
+		return true;
+	}
+private:
+	const char* cur;
+	const char* end;
+};
 
 struct stream_parse_error {
 	unsigned line;
@@ -51,27 +91,35 @@ struct parsed_atom : public atom {
 	}
 };
 
-void add_context(context& c, std::string& str) {
-	c.push_back(parsed_line(str, boost::optional<sz>()));
+void add_context(context& c, const line_ref& str) { // the only copy of a line that is made - it's needed for the output
+	c.push_back(parsed_line(str.str(), boost::optional<sz>()));
 }
 
-std::string omit_whitespace(const std::string& str, sz i, sz j) {
+std::string omit_whitespace(const line_ref& str, sz i, sz j) {
 	if(i < 1) i = 1;
 	if(j < i-1) j = i-1; // i >= 1
-	if(j < str.size()) j = str.size();
+	if(j < str.size) j = str.size;
 
 	// omit leading whitespace
-	while(i <= j && std::isspace(str[i-1]))
+	while(i <= j && std::isspace(str.begin[i-1]))
 		++i;
 
 	// omit trailing whitespace
-	while(i <= j && std::isspace(str[j-1]))
+	while(i <= j && std::isspace(str.begin[j-1]))
 		--j;
 
-	VINA_CHECK(i-1 < str.size());
-	VINA_CHECK(j-i+1 < str.size());
+	VINA_CHECK(i-1 < str.size);
+	VINA_CHECK(j-i+1 < str.size);
+
+	return str.substr(i-1, j-i+1); // atom types are short enough not to allocate
+}
 
-	return str.substr(i-1, j-i+1);
+bool substring_is_blank(const line_ref& str, sz i, sz j) { // indexes are 1-based, the substring should be non-null
+	if(i < 1 || i > j+1 || j > str.size) throw bad_conversion();
+	VINA_RANGE(k, i-1, j)
+		if(!std::isspace(str.begin[k]))
+			return false;
+	return true;
 }
 
 struct atom_syntax_error {
@@ -79,26 +127,46 @@ struct atom_syntax_error {
 	atom_syntax_error(const std::string& nature_) : nature(nature_) {}
 };
 
+// the whole field, a null-terminated copy, has to be the number
+bool convert_field(const char* field, unsigned& out) {
+	if(!std::isdigit(field[0]) && field[0] != '+') return false;
+	char* rest;
+	unsigned long tmp = std::strtoul(field, &rest, 10);
+	if(*rest != '\0' || tmp > max_unsigned) return false;
+	out = unsigned(tmp);
+	return true;
+}
+
+bool convert_field(const char* field, fl& out) {
+	char* rest;
+	out = std::strtod(field, &rest);
+	return rest != field && *rest == '\0';
+}
+
+const sz max_field_width = 16; // the fixed-column fields are at most 8 wide
+
 template<typename T>
-T checked_convert_substring(const std::string& str, sz i, sz j, const std::string& dest_nature) {
+T checked_convert_substring(const line_ref& str, sz i, sz j, const char* dest_nature) {
 	VINA_CHECK(i >= 1);
 	VINA_CHECK(i <= j+1);
-	if(j > str.size()) throw atom_syntax_error("The line is too short");
+	VINA_CHECK(j-i+1 < max_field_width);
+	if(j > str.size) throw atom_syntax_error("The line is too short");
 
 	// omit leading whitespace
-	while(i <= j && std::isspace(str[i-1]))
+	while(i <= j && std::isspace(str.begin[i-1]))
 		++i;
 
-	const std::string substr = str.substr(i-1, j-i+1);
-	try {
-		return boost::lexical_cast<T>(substr);
-	}
-	catch(...) {
-		throw atom_syntax_error(std::string("\"") + substr + "\" is not a valid " + dest_nature);
-	}
+	char field[max_field_width]; // copied to the stack only to null-terminate it
+	const sz n = j-i+1;
+	std::memcpy(field, str.begin + i-1, n);
+	field[n] = '\0';
+	T tmp;
+	if(n == 0 || !convert_field(field, tmp))
+		throw atom_syntax_error(std::string("\"") + field + "\" is not a valid " + dest_nature);
+	return tmp;
 }
 
-parsed_atom parse_pdbqt_atom_string(const std::string& str) {
+parsed_atom parse_pdbqt_atom_string(const line_ref& str) {
 	unsigned number = checked_convert_substring<unsigned>(str, 7, 11, "atom number");
 	vec coords(checked_convert_substring<fl>(str, 31, 38, "coordinate"),
 			   checked_convert_substring<fl>(str, 39, 46, "coordinate"),
@@ -235,37 +303,53 @@ struct parsing_struct {
 	}
 };
 
-unsigned parse_one_unsigned(const std::string& str, const std::string& start, unsigned count) {
-	std::istringstream in_str(str.substr(start.size()));
+bool read_int(const char*& p, const char* end, int& out) { // like "in >> out": skips leading whitespace, stops after the digits
+	while(p != end && std::isspace(*p))
+		++p;
+	bool negative = false;
+	if(p != end && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		++p;
+	}
+	if(p == end || !std::isdigit(*p)) return false;
+	long tmp = 0;
+	for(; p != end && std::isdigit(*p); ++p) {
+		tmp = 10 * tmp + (*p - '0');
+		if(tmp > (std::numeric_limits<int>::max)()) return false;
+	}
+	out = int(negative ? -tmp : tmp);
+	return true;
+}
+
+unsigned parse_one_unsigned(const line_ref& str, const char* start, unsigned count) {
+	const char* p = str.begin + std::strlen(start);
 	int tmp;
-	in_str >> tmp;
-	if(!in_str || tmp < 0) 
+	if(!read_int(p, str.begin + str.size, tmp) || tmp < 0) 
 		throw stream_parse_error(count, "Syntax error");
 	return unsigned(tmp);
 }
 
-void parse_two_unsigneds(const std::string& str, const std::string& start, unsigned count, unsigned& first, unsigned& second) {
-	std::istringstream in_str(str.substr(start.size()));
+void parse_two_unsigneds(const line_ref& str, const char* start, unsigned count, unsigned& first, unsigned& second) {
+	const char* p = str.begin + std::strlen(start);
+	const char* end = str.begin + str.size;
 	int tmp1, tmp2;
-	in_str >> tmp1;
-	in_str >> tmp2;
-	if(!in_str || tmp1 < 0 || tmp2 < 0) 
+	if(!read_int(p, end, tmp1) || !read_int(p, end, tmp2) || tmp1 < 0 || tmp2 < 0) 
 		throw stream_parse_error(count, "Syntax error");
 	first = unsigned(tmp1);
 	second = unsigned(tmp2);
 }
 
-void parse_pdbqt_rigid(const path& name, rigid& r) {
-	ifile in(name);
+void parse_pdbqt_rigid(const path& name, const char* begin, const char* end, rigid& r) {
+	line_reader in(begin, end);
 	unsigned count = 0;
-	std::string str;
-	while(std::getline(in, str)) {
+	line_ref str;
+	while(in.next(str)) {
 		++count;
 		if(str.empty()) {} // ignore ""
-		else if(starts_with(str, "TER")) {} // ignore 
-		else if(starts_with(str, "WARNING")) {} // ignore - AutoDockTools bug workaround
-		else if(starts_with(str, "REMARK")) {} // ignore
-		else if(starts_with(str, "ATOM  ") || starts_with(str, "HETATM")) {
+		else if(str.starts_with("TER")) {} // ignore 
+		else if(str.starts_with("WARNING")) {} // ignore - AutoDockTools bug workaround
+		else if(str.starts_with("REMARK")) {} // ignore
+		else if(str.starts_with("ATOM  ") || str.starts_with("HETATM")) {
 			try {
 				r.atoms.push_back(parse_pdbqt_atom_string(str));
 			}
@@ -276,22 +360,22 @@ void parse_pdbqt_rigid(const path& name, rigid& r) {
 				throw parse_error(name, count, "ATOM syntax incorrect");
 			}
 		}
-		else if(starts_with(str, "MODEL"))
+		else if(str.starts_with("MODEL"))
 			throw stream_parse_error(count, "Unexpected multi-MODEL input. Use \"vina_split\" first?");
 		else throw parse_error(name, count, "Unknown or inappropriate tag");
 	}
 }
 
 
-void parse_pdbqt_root_aux(std::istream& in, unsigned& count, parsing_struct& p, context& c) {
-	std::string str;
-	while(std::getline(in, str)) {
+void parse_pdbqt_root_aux(line_reader& in, unsigned& count, parsing_struct& p, context& c) {
+	line_ref str;
+	while(in.next(str)) {
 		add_context(c, str);
 		++count;
 		if(str.empty()) {} // ignore ""
-		else if(starts_with(str, "WARNING")) {} // ignore - AutoDockTools bug workaround
-		else if(starts_with(str, "REMARK")) {} // ignore
-		else if(starts_with(str, "ATOM  ") || starts_with(str, "HETATM")) {
+		else if(str.starts_with("WARNING")) {} // ignore - AutoDockTools bug workaround
+		else if(str.starts_with("REMARK")) {} // ignore
+		else if(str.starts_with("ATOM  ") || str.starts_with("HETATM")) {
 			try {
 				p.add(parse_pdbqt_atom_string(str), c);
 			}
@@ -302,34 +386,34 @@ void parse_pdbqt_root_aux(std::istream& in, unsigned& count, parsing_struct& p,
 				throw stream_parse_error(count, "ATOM syntax incorrect");
 			}
 		}
-		else if(starts_with(str, "ENDROOT")) return;
-		else if(starts_with(str, "MODEL"))
+		else if(str.starts_with("ENDROOT")) return;
+		else if(str.starts_with("MODEL"))
 			throw stream_parse_error(count, "Unexpected multi-MODEL input. Use \"vina_split\" first?");
 		else throw stream_parse_error(count, "Unknown or inappropriate tag");
 	}
 }
 
-void parse_pdbqt_root(std::istream& in, unsigned& count, parsing_struct& p, context& c) {
-	std::string str;
-	while(std::getline(in, str)) {
+void parse_pdbqt_root(line_reader& in, unsigned& count, parsing_struct& p, context& c) {
+	line_ref str;
+	while(in.next(str)) {
 		add_context(c, str);
 		++count;
 		if(str.empty()) {} // ignore
-		else if(starts_with(str, "WARNING")) {} // ignore - AutoDockTools bug workaround
-		else if(starts_with(str, "REMARK")) {} // ignore
-		else if(starts_with(str, "ROOT")) {
+		else if(str.starts_with("WARNING")) {} // ignore - AutoDockTools bug workaround
+		else if(str.starts_with("REMARK")) {} // ignore
+		else if(str.starts_with("ROOT")) {
 			parse_pdbqt_root_aux(in, count, p, c);
 			break;
 		}
-		else if(starts_with(str, "MODEL"))
+		else if(str.starts_with("MODEL"))
 			throw stream_parse_error(count, "Unexpected multi-MODEL input. Use \"vina_split\" first?");
 		else throw stream_parse_error(count, "Unknown or inappropriate tag");
 	}
 }
 
-void parse_pdbqt_branch(std::istream& in, unsigned& count, parsing_struct& p, context& c, unsigned from, unsigned to); // forward declaration
+void parse_pdbqt_branch(line_reader& in, unsigned& count, parsing_struct& p, context& c, unsigned from, unsigned to); // forward declaration
 
-void parse_pdbqt_branch_aux(std::istream& in, unsigned& count, const std::string& str, parsing_struct& p, context& c) {
+void parse_pdbqt_branch_aux(line_reader& in, unsigned& count, const line_ref& str, parsing_struct& p, context& c) {
 	unsigned first, second;
 	parse_two_unsigneds(str, "BRANCH", count, first, second); 
 	sz i = 0;
@@ -343,23 +427,23 @@ void parse_pdbqt_branch_aux(std::istream& in, unsigned& count, const std::string
 		throw stream_parse_error(count, "No atom number " + boost::lexical_cast<std::string>(first) + " in this branch");
 }
 
-void parse_pdbqt_aux(std::istream& in, unsigned& count, parsing_struct& p, context& c, boost::optional<unsigned>& torsdof, bool residue) {
+void parse_pdbqt_aux(line_reader& in, unsigned& count, parsing_struct& p, context& c, boost::optional<unsigned>& torsdof, bool residue) {
 	parse_pdbqt_root(in, count, p, c);
 
-	std::string str;
-	while(std::getline(in, str)) {
+	line_ref str;
+	while(in.next(str)) {
 		add_context(c, str);
 		++count;
 		if(str.empty()) {} // ignore ""
-		else if(starts_with(str, "WARNING")) {} // ignore - AutoDockTools bug workaround
-		else if(starts_with(str, "REMARK")) {} // ignore
-		else if(starts_with(str, "BRANCH")) parse_pdbqt_branch_aux(in, count, str, p, c);
-		else if(!residue && starts_with(str, "TORSDOF")) {
+		else if(str.starts_with("WARNING")) {} // ignore - AutoDockTools bug workaround
+		else if(str.starts_with("REMARK")) {} // ignore
+		else if(str.starts_with("BRANCH")) parse_pdbqt_branch_aux(in, count, str, p, c);
+		else if(!residue && str.starts_with("TORSDOF")) {
 			if(torsdof) throw stream_parse_error(count, "TORSDOF can occur only once");
 			torsdof = parse_one_unsigned(str, "TORSDOF", count);
 		}
-		else if(residue && starts_with(str, "END_RES")) return; 
-		else if(starts_with(str, "MODEL"))
+		else if(residue && str.starts_with("END_RES")) return; 
+		else if(str.starts_with("MODEL"))
 			throw stream_parse_error(count, "Unexpected multi-MODEL input. Use \"vina_split\" first?");
 		else throw stream_parse_error(count, "Unknown or inappropriate tag");
 	}
@@ -468,8 +552,8 @@ void postprocess_residue(non_rigid_parsed& nr, parsing_struct& p, context& c) {
 	VINA_CHECK(nr.atoms_inflex_bonds.dim_2() == nr.inflex.size());
 }
 
-void parse_pdbqt_ligand(const path& name, non_rigid_parsed& nr, context& c) {
-	ifile in(name);
+void parse_pdbqt_ligand(const path& name, const char* begin, const char* end, non_rigid_parsed& nr, context& c) {
+	line_reader in(begin, end);
 	unsigned count = 0;
 	parsing_struct p;
 	boost::optional<unsigned> torsdof;
@@ -487,23 +571,23 @@ void parse_pdbqt_ligand(const path& name, non_rigid_parsed& nr, context& c) {
 	VINA_CHECK(nr.atoms_atoms_bonds.dim() == nr.atoms.size());
 }
 
-void parse_pdbqt_residue(std::istream& in, unsigned& count, parsing_struct& p, context& c) { 
+void parse_pdbqt_residue(line_reader& in, unsigned& count, parsing_struct& p, context& c) { 
 	boost::optional<unsigned> dummy;
 	parse_pdbqt_aux(in, count, p, c, dummy, true);
 }
 
 void parse_pdbqt_flex(const path& name, non_rigid_parsed& nr, context& c) {
-	ifile in(name);
+	mapped_file f(name);
+	line_reader in(f.data(), f.end());
 	unsigned count = 0;
-	std::string str;
-
-	while(std::getline(in, str)) {
+	line_ref str;
+	while(in.next(str)) {
 		add_context(c, str);
 		++count;
 		if(str.empty()) {} // ignore ""
-		else if(starts_with(str, "WARNING")) {} // ignore - AutoDockTools bug workaround
-		else if(starts_with(str, "REMARK")) {} // ignore
-		else if(starts_with(str, "BEGIN_RES")) {
+		else if(str.starts_with("WARNING")) {} // ignore - AutoDockTools bug workaround
+		else if(str.starts_with("REMARK")) {} // ignore
+		else if(str.starts_with("BEGIN_RES")) {
 			try {
 				parsing_struct p;
 				parse_pdbqt_residue(in, count, p, c);
@@ -513,23 +597,23 @@ void parse_pdbqt_flex(const path& name, non_rigid_parsed& nr, context& c) {
 				throw e.to_parse_error(name);
 			}
 		}
-		else if(starts_with(str, "MODEL"))
+		else if(str.starts_with("MODEL"))
 			throw stream_parse_error(count, "Unexpected multi-MODEL input. Use \"vina_split\" first?");
 		else throw parse_error(name, count, "Unknown or inappropriate tag");
 	}
 	VINA_CHECK(nr.atoms_atoms_bonds.dim() == nr.atoms.size());
 }
 
-void parse_pdbqt_branch(std::istream& in, unsigned& count, parsing_struct& p, context& c, unsigned from, unsigned to) {
-	std::string str;
-	while(std::getline(in, str)) {
+void parse_pdbqt_branch(line_reader& in, unsigned& count, parsing_struct& p, context& c, unsigned from, unsigned to) {
+	line_ref str;
+	while(in.next(str)) {
 		add_context(c, str);
 		++count;
 		if(str.empty()) {} //ignore ""
-		else if(starts_with(str, "WARNING")) {} // ignore - AutoDockTools bug workaround
-		else if(starts_with(str, "REMARK")) {} // ignore
-		else if(starts_with(str, "BRANCH")) parse_pdbqt_branch_aux(in, count, str, p, c);
-		else if(starts_with(str, "ENDBRANCH")) {
+		else if(str.starts_with("WARNING")) {} // ignore - AutoDockTools bug workaround
+		else if(str.starts_with("REMARK")) {} // ignore
+		else if(str.starts_with("BRANCH")) parse_pdbqt_branch_aux(in, count, str, p, c);
+		else if(str.starts_with("ENDBRANCH")) {
 			unsigned first, second;
 			parse_two_unsigneds(str, "ENDBRANCH", count, first, second);
 			if(first != from || second != to) 
@@ -538,7 +622,7 @@ void parse_pdbqt_branch(std::istream& in, unsigned& count, parsing_struct& p, co
 				throw stream_parse_error(count, "Atom " + boost::lexical_cast<std::string>(to) + " has not been found in this branch");
 			return;
 		}
-		else if(starts_with(str, "ATOM  ") || starts_with(str, "HETATM")) {
+		else if(str.starts_with("ATOM  ") || str.starts_with("HETATM")) {
 			try {
 				parsed_atom a = parse_pdbqt_atom_string(str);
 				if(a.number == to)
@@ -552,7 +636,7 @@ void parse_pdbqt_branch(std::istream& in, unsigned& count, parsing_struct& p, co
 				throw stream_parse_error(count, "ATOM syntax incorrect");
 			}
 		}
-		else if(starts_with(str, "MODEL"))
+		else if(str.starts_with("MODEL"))
 			throw stream_parse_error(count, "Unexpected multi-MODEL input. Use \"vina_split\" first?");
 		else throw stream_parse_error(count, "Unknown or inappropriate tag");
 	}
@@ -610,43 +694,212 @@ struct pdbqt_initializer {
 			m.flex_context = c;
 
 	}
-	void initialize(const distance_type_matrix& mobility) {
-		m.initialize(mobility);
+	void initialize(const distance_type_matrix& mobility, sz num_threads) {
+		m.initialize(mobility, num_threads);
 	}
 };
 
-model parse_ligand_pdbqt  (const path& name) { // can throw parse_error
-	non_rigid_parsed nrp;
-	context c;
-	parse_pdbqt_ligand(name, nrp, c);
-
+model ligand_model(const non_rigid_parsed& nrp, const context& c) {
 	pdbqt_initializer tmp;
 	tmp.initialize_from_nrp(nrp, c, true);
-	tmp.initialize(nrp.mobility_matrix());
+	tmp.initialize(nrp.mobility_matrix(), 1); // too small for threads
 	return tmp.m;
 }
 
-model parse_receptor_pdbqt(const path& rigid_name, const path& flex_name) { // can throw parse_error
+model parse_ligand_pdbqt  (const path& name, const char* begin, const char* end) { // can throw parse_error
+	non_rigid_parsed nrp;
+	context c;
+	parse_pdbqt_ligand(name, begin, end, nrp, c);
+	return ligand_model(nrp, c);
+}
+
+unsigned count_lines(const char* begin, const char* end) {
+	return unsigned(std::count(begin, end, '\n'));
+}
+
+pdbqt_model_spans index_multimodel_pdbqt(const path& name, const char* begin, const char* end, sz slice, sz num_slices) { // can throw parse_error
+	VINA_CHECK(slice < num_slices);
+	const sz size = end - begin;
+	const sz slice_size = size / num_slices; // the remainder goes to the last slice
+	const char* slice_begin = begin + slice * slice_size;
+	const char* slice_end   = (slice + 1 == num_slices) ? end : slice_begin + slice_size;
+
+	// start from the first line that begins inside the slice
+	if(slice_begin != begin && slice_begin[-1] != '\n') {
+		const char* nl = static_cast<const char*>(std::memchr(slice_begin, '\n', end - slice_begin));
+		slice_begin = nl ? nl + 1 : end;
+	}
+
+	pdbqt_model_spans tmp;
+	line_reader in(slice_begin, end);
+	unsigned count = 0;
+	bool parsing_model = false;
+	bool synchronized = (slice == 0); // the lines before the first MODEL of a later slice belong to the previous one
+	line_ref str;
+	try {
+		while(in.next(str)) {
+			++count;
+			if(str.starts_with("MODEL")) {
+				if(str.begin >= slice_end) break; // the next slice's
+				if(parsing_model) 
+					throw stream_parse_error(count, "Misplaced MODEL tag");
+				pdbqt_model_span s;
+				s.tag = str.begin - begin;
+				s.begin = std::min(s.tag + str.size + 1, size);
+				s.end = s.begin;
+				tmp.push_back(s);
+				parsing_model = true;
+				synchronized = true;
+			}
+			else if(!synchronized) {
+				if(str.begin >= slice_end) break; // no MODEL starts in this slice
+			}
+			else if(str.starts_with("ENDMDL")) {
+				if(!parsing_model)
+					throw stream_parse_error(count, "Misplaced ENDMDL tag");
+				tmp.back().end = str.begin - begin;
+				parsing_model = false;
+			}
+			else if(!parsing_model && !str.blank())
+				throw stream_parse_error(count, "Input occurs outside MODEL");
+		}
+		if(parsing_model)
+			throw stream_parse_error(count + 1, "Missing ENDMDL tag");
+	}
+	catch(stream_parse_error& e) {
+		e.line += count_lines(begin, slice_begin); // only counted when it's needed
+		throw e.to_parse_error(name);
+	}
+	return tmp;
+}
+
+model parse_ligand_pdbqt  (const path& name, const char* begin, const char* end, const std::string& model_tag) { // can throw parse_error
+	non_rigid_parsed nrp;
+	context c;
+
+	sz tag_size = model_tag.size();
+	while(tag_size > 0 && std::isspace(model_tag[tag_size - 1]))
+		--tag_size;
+	c.push_back(parsed_line("REMARK VINA LIBRARY " + model_tag.substr(0, tag_size), boost::optional<sz>()));
+
+	parse_pdbqt_ligand(name, begin, end, nrp, c);
+	return ligand_model(nrp, c);
+}
+
+model parse_ligand_pdbqt  (const path& name, const char* file_begin, const pdbqt_model_span& span) { // can throw parse_error
+	try {
+		return parse_ligand_pdbqt(name, file_begin + span.begin, file_begin + span.end, std::string(file_begin + span.tag, span.begin - span.tag));
+	}
+	catch(parse_error& e) {
+		e.line += count_lines(file_begin, file_begin + span.begin);
+		throw;
+	}
+}
+
+model parse_ligand_pdbqt  (const path& name) { // can throw parse_error
+	mapped_file f(name);
+	return parse_ligand_pdbqt(name, f.data(), f.end());
+}
+
+template<typename T> // T == residue || branch
+fl branch_reach(const T& b, const mav& atoms) { // the farthest its atoms can get from its origin, whatever the torsions
+	const vec& origin = b.node.get_origin();
+	fl tmp = 0;
+	VINA_RANGE(i, b.node.begin, b.node.end)
+		tmp = (std::max)(tmp, std::sqrt(vec_distance_sqr(atoms[i].coords, origin)));
+	VINA_FOR_IN(i, b.children)
+		tmp = (std::max)(tmp, std::sqrt(vec_distance_sqr(b.children[i].node.get_origin(), origin)) + branch_reach(b.children[i], atoms));
+	return tmp;
+}
+
+void crop_rigid(rigid& r, const non_rigid_parsed& nrp, receptor_crop& crop) {
+	const fl bond_length_allowance_factor = 1.1; // as in model::assign_bonds
+	const fl keep = crop.cutoff + bond_length_allowance_factor * 2 * max_covalent_radius();
+	const fl keep_sqr = sqr(keep);
+
+	// the flexible side chains are not confined to the box: they interact with anything within reach of their fixed atoms
+	std::vector<std::pair<vec, fl> > reachable;
+	VINA_FOR_IN(i, nrp.flex)
+		reachable.push_back(std::make_pair(nrp.flex[i].node.get_origin(), branch_reach(nrp.flex[i], nrp.atoms)));
+	VINA_FOR_IN(i, nrp.inflex)
+		reachable.push_back(std::make_pair(nrp.inflex[i].coords, fl(0)));
+
+	crop.parsed = r.atoms.size();
+	atomv tmp;
+	VINA_FOR_IN(i, r.atoms) {
+		const atom& a = r.atoms[i];
+		bool near = brick_distance_sqr(crop.corner1, crop.corner2, a.coords) < keep_sqr;
+		for(sz j = 0; !near && j < reachable.size(); ++j)
+			near = vec_distance_sqr(reachable[j].first, a.coords) < sqr(reachable[j].second + keep);
+		if(near)
+			tmp.push_back(a); // the order is kept, and with it the order of the sums over the atoms
+	}
+	crop.kept = tmp.size();
+	r.atoms.swap(tmp);
+}
+
+model receptor_model(const path& rigid_name, const path& flex_name, receptor_crop* crop, sz num_threads) { // can throw parse_error
 	rigid r;
 	non_rigid_parsed nrp;
 	context c;
-	parse_pdbqt_rigid(rigid_name, r);
+	{
+		mapped_file f(rigid_name);
+		parse_pdbqt_rigid(rigid_name, f.data(), f.end(), r);
+	}
 	parse_pdbqt_flex(flex_name, nrp, c);
+	if(crop)
+		crop_rigid(r, nrp, *crop);
 
 	pdbqt_initializer tmp;
 	tmp.initialize_from_rigid(r);
 	tmp.initialize_from_nrp(nrp, c, false);
-	tmp.initialize(nrp.mobility_matrix());
+	tmp.initialize(nrp.mobility_matrix(), num_threads);
 	return tmp.m;
 }
 
-model parse_receptor_pdbqt(const path& rigid_name) { // can throw parse_error
+model receptor_model(const path& rigid_name, const char* begin, const char* end, receptor_crop* crop, sz num_threads) { // can throw parse_error
 	rigid r;
-	parse_pdbqt_rigid(rigid_name, r);
+	parse_pdbqt_rigid(rigid_name, begin, end, r);
+	if(crop)
+		crop_rigid(r, non_rigid_parsed(), *crop);
 
 	pdbqt_initializer tmp;
 	tmp.initialize_from_rigid(r);
 	distance_type_matrix mobility_matrix;
-	tmp.initialize(mobility_matrix);
+	tmp.initialize(mobility_matrix, num_threads);
 	return tmp.m;
 }
+
+model parse_receptor_pdbqt(const path& rigid_name, const path& flex_name, sz num_threads) { // can throw parse_error
+	return receptor_model(rigid_name, flex_name, NULL, num_threads);
+}
+
+model parse_receptor_pdbqt(const path& rigid_name, const path& flex_name, receptor_crop& crop, sz num_threads) { // can throw parse_error
+	return receptor_model(rigid_name, flex_name, &crop, num_threads);
+}
+
+model parse_receptor_pdbqt(const path& rigid_name, const char* begin, const char* end, sz num_threads) { // can throw parse_error
+	return receptor_model(rigid_name, begin, end, NULL, num_threads);
+}
+
+model parse_receptor_pdbqt(const path& rigid_name, const char* begin, const char* end, receptor_crop& crop, sz num_threads) { // can throw parse_error
+	return receptor_model(rigid_name, begin, end, &crop, num_threads);
+}
+
+model parse_receptor_pdbqt(const path& rigid_name, sz num_threads) { // can throw parse_error
+	mapped_file f(rigid_name);
+	return parse_receptor_pdbqt(rigid_name, f.data(), f.end(), num_threads);
+}
+
+model parse_receptor_pdbqt(const path& rigid_name, receptor_crop& crop, sz num_threads) { // can throw parse_error
+	mapped_file f(rigid_name);
+	return receptor_model(rigid_name, f.data(), f.end(), &crop, num_threads);
+}
+
+atomv parse_receptor_atoms_pdbqt(const path& rigid_name, const char* begin, const char* end) { // can throw parse_error
+	rigid r;
+	parse_pdbqt_rigid(rigid_name, begin, end, r);
+	atomv tmp;
+	tmp.swap(r.atoms);
+	return tmp;
+}
@@ -25,8 +25,46 @@
 
 #include "model.h"
 
-model parse_receptor_pdbqt(const path& rigid, const path& flex); // can throw parse_error
-model parse_receptor_pdbqt(const path& rigid); // can throw parse_error
+// bonding a large receptor uses up to num_threads threads
+model parse_receptor_pdbqt(const path& rigid, const path& flex, sz num_threads = 1); // can throw parse_error
+model parse_receptor_pdbqt(const path& rigid, sz num_threads = 1); // can throw parse_error
+
+// when only a search box is going to be used, the rigid atoms that can not interact with anything in it are dropped right after parsing,
+// before bonding and typing; the atoms within a bond's length of the kept ones stay too, so that the typing of those does not change
+struct receptor_crop {
+	vec corner1, corner2; // the search box
+	fl cutoff;            // of the scoring function
+	sz parsed, kept;      // the numbers of rigid atoms, filled in by parsing
+	receptor_crop(const vec& corner1_, const vec& corner2_, fl cutoff_) : corner1(corner1_), corner2(corner2_), cutoff(cutoff_), parsed(0), kept(0) {}
+};
+
+model parse_receptor_pdbqt(const path& rigid, const path& flex, receptor_crop& crop, sz num_threads = 1); // can throw parse_error
+model parse_receptor_pdbqt(const path& rigid, receptor_crop& crop, sz num_threads = 1); // can throw parse_error
 model parse_ligand_pdbqt  (const path& name); // can throw parse_error
 
+// the same, from contents already in memory; the name is only used in error messages
+model parse_receptor_pdbqt(const path& rigid, const char* begin, const char* end, sz num_threads = 1); // can throw parse_error
+model parse_receptor_pdbqt(const path& rigid, const char* begin, const char* end, receptor_crop& crop, sz num_threads = 1); // can throw parse_error
+model parse_ligand_pdbqt  (const path& name,  const char* begin, const char* end); // can throw parse_error
+
+atomv parse_receptor_atoms_pdbqt(const path& rigid, const char* begin, const char* end); // just the atoms, without setting up the model; can throw parse_error
+
+// multi-MODEL PDBQT (MODEL/ENDMDL framing, as in vina_split) used as a ligand library
+struct pdbqt_model_span { // byte offsets into the file
+	sz tag;   // the MODEL line
+	sz begin; // the line after it
+	sz end;   // the ENDMDL line
+};
+typedef std::vector<pdbqt_model_span> pdbqt_model_spans;
+
+// the MODELs whose MODEL line starts in slice k of n equal byte ranges of the file (0 <= k < n);
+// only that range and the tail of its last MODEL are read, so that independent workers can split a library without a shared index
+pdbqt_model_spans index_multimodel_pdbqt(const path& name, const char* begin, const char* end, sz slice, sz num_slices); // can throw parse_error
+
+// the ligand in one MODEL of the file starting at file_begin; the MODEL line is kept as a "REMARK VINA LIBRARY" line for the output
+model parse_ligand_pdbqt  (const path& name, const char* file_begin, const pdbqt_model_span& span); // can throw parse_error, with line numbers within the whole file
+
+// the same, for the contents of a MODEL already extracted from the file; line numbers are counted from its first line
+model parse_ligand_pdbqt  (const path& name, const char* begin, const char* end, const std::string& model_tag); // can throw parse_error
+
 #endif
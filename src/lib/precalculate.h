@@ -24,36 +24,31 @@
 #define VINA_PRECALCULATE_H
 
 #include "scoring_function.h"
-#include "matrix.h"
-
-struct precalculate_element {
-	precalculate_element(sz n, fl factor_) : fast(n, 0), smooth(n, pr(0, 0)), factor(factor_) {}
-	fl eval_fast(fl r2) const {
-		assert(r2 * factor < fast.size());
-		sz i = sz(factor * r2);  // r2 is expected < cutoff_sqr, and cutoff_sqr * factor + 1 < n, so no overflow
-		assert(i < fast.size()); 
-		return fast[i];
-	}
-	pr eval_deriv(fl r2) const {
-		fl r2_factored = factor * r2;
-		assert(r2_factored + 1 < smooth.size());
-		sz i1 = sz(r2_factored); 
-		sz i2 = i1 + 1; // r2 is expected < cutoff_sqr, and cutoff_sqr * factor + 1 < n, so no overflow
-		assert(i1 < smooth.size());
-		assert(i2 < smooth.size());
-		fl rem = r2_factored - i1;
-		assert(rem >= -epsilon_fl);
-		assert(rem < 1 + epsilon_fl);
-		const pr& p1 = smooth[i1];
-		const pr& p2 = smooth[i2];
-		fl e   = p1.first  + rem * (p2.first  - p1.first);
-		fl dor = p1.second + rem * (p2.second - p1.second); 
-		return pr(e, dor);
-	}
+#include "triangular_matrix_index.h"
+#include "huge_pages.h"
+
+inline pr smooth_eval_deriv(const pr* smooth, sz n, fl factor, fl r2) {
+	fl r2_factored = factor * r2;
+	assert(r2_factored + 1 < n);
+	sz i1 = sz(r2_factored); 
+	sz i2 = i1 + 1; // r2 is expected < cutoff_sqr, and cutoff_sqr * factor + 1 < n, so no overflow
+	assert(i1 < n);
+	assert(i2 < n);
+	fl rem = r2_factored - i1;
+	assert(rem >= -epsilon_fl);
+	assert(rem < 1 + epsilon_fl);
+	const pr& p1 = smooth[i1];
+	const pr& p2 = smooth[i2];
+	fl e   = p1.first  + rem * (p2.first  - p1.first);
+	fl dor = p1.second + rem * (p2.second - p1.second); 
+	return pr(e, dor);
+}
+
+struct precalculate_element { // the tables of one pair of atom types, within those of precalculate
+	precalculate_element(fl* fast_, pr* smooth_, sz n_, fl factor_) : fast(fast_), smooth(smooth_), n(n_), factor(factor_) {}
+	pr eval_deriv(fl r2) const { return smooth_eval_deriv(smooth, n, factor, r2); }
 	void init_from_smooth_fst(const flv& rs) {
-		sz n = smooth.size();
 		VINA_CHECK(rs.size() == n);
-		VINA_CHECK(fast.size() == n);
 		VINA_FOR(i, n) {
 			// calculate dor's
 			fl& dor = smooth[i].second;
@@ -71,21 +66,21 @@ struct precalculate_element {
 		}
 	}
 	sz min_smooth_fst() const {
-		sz tmp = 0; // returned if smooth.empty()
-		VINA_FOR_IN(i_inv, smooth) {
-			sz i = smooth.size() - i_inv - 1; // i_inv < smooth.size()  => i_inv + 1 <= smooth.size()
+		sz tmp = 0; // returned if n == 0
+		VINA_FOR(i_inv, n) {
+			sz i = n - i_inv - 1; // i_inv < n  => i_inv + 1 <= n
 			if(i_inv == 0 || smooth[i].first < smooth[tmp].first)
 				tmp = i;
 		}
 		return tmp;
 	}
 	void widen_smooth_fst(const flv& rs, fl left, fl right) {
-		flv tmp(smooth.size(), 0); // the new smooth[].first's
+		flv tmp(n, 0); // the new smooth[].first's
 		sz min_index = min_smooth_fst();
 		VINA_CHECK(min_index < rs.size()); // won't hold for n == 0
-		VINA_CHECK(rs.size() == smooth.size());
+		VINA_CHECK(rs.size() == n);
 		fl optimal_r   = rs[min_index];
-		VINA_FOR_IN(i, smooth) {
+		VINA_FOR(i, n) {
 			fl r = rs[i];
 			if     (r < optimal_r - left ) r += left;
 			else if(r > optimal_r + right) r -= right;
@@ -96,15 +91,16 @@ struct precalculate_element {
 
 			tmp[i] = eval_deriv(sqr(r)).first;
 		}
-		VINA_FOR_IN(i, smooth)
+		VINA_FOR(i, n)
 			smooth[i].first = tmp[i];
 	}
 	void widen(const flv& rs, fl left, fl right) {
 		widen_smooth_fst(rs, left, right);
 		init_from_smooth_fst(rs);
 	}
-	flv fast;
-	prv smooth; // [(e, dor)]
+	fl* fast;
+	pr* smooth; // [(e, dor)]
+	sz n;
 	fl factor;
 };
 
@@ -113,9 +109,12 @@ struct precalculate {
 		m_cutoff_sqr(sqr(sf.cutoff())),
 		n(sz(factor_ * m_cutoff_sqr) + 3),  // sz(factor * r^2) + 1 <= sz(factor * cutoff_sqr) + 2 <= n-1 < n  // see assert below
 		factor(factor_),
+		m_atom_typing_used(sf.atom_typing_used()),
+		num_types(num_atom_types(sf.atom_typing_used())),
 
-		data(num_atom_types(sf.atom_typing_used()), precalculate_element(n, factor_)),
-		m_atom_typing_used(sf.atom_typing_used()) {
+		// all the pairs in one block each, rather than a vector each, so that huge pages can cover them
+		fast  (num_types * (num_types + 1) / 2 * n, 0),
+		smooth(num_types * (num_types + 1) / 2 * n, pr(0, 0)) {
 
 		VINA_CHECK(factor > epsilon_fl);
 		VINA_CHECK(sz(m_cutoff_sqr*factor) + 1 < n); // cutoff_sqr * factor is the largest float we may end up converting into sz, then 1 can be added to the result
@@ -123,11 +122,11 @@ struct precalculate {
 
 		flv rs = calculate_rs();
 
-		VINA_FOR(t1, data.dim())
-			VINA_RANGE(t2, t1, data.dim()) {
-				precalculate_element& p = data(t1, t2);
+		VINA_FOR(t1, num_types)
+			VINA_RANGE(t2, t1, num_types) {
+				precalculate_element p = element(triangular_matrix_index(num_types, t1, t2));
 				// init smooth[].first
-				VINA_FOR_IN(i, p.smooth)
+				VINA_FOR(i, n)
 					p.smooth[i].first = (std::min)(v, sf.eval(t1, t2, rs[i]));
 
 				// init the rest
@@ -136,20 +135,23 @@ struct precalculate {
 	}
 	fl eval_fast(sz type_pair_index, fl r2) const {
 		assert(r2 <= m_cutoff_sqr);
-		return data(type_pair_index).eval_fast(r2);
+		assert(r2 * factor < n);
+		sz i = sz(factor * r2);  // r2 is expected < cutoff_sqr, and cutoff_sqr * factor + 1 < n, so no overflow
+		assert(i < n); 
+		return fast[type_pair_index * n + i];
 	}
 	pr eval_deriv(sz type_pair_index, fl r2) const {
 		assert(r2 <= m_cutoff_sqr);
-		return data(type_pair_index).eval_deriv(r2);
+		return smooth_eval_deriv(&smooth[type_pair_index * n], n, factor, r2);
 	}
-	sz index_permissive(sz t1, sz t2) const { return data.index_permissive(t1, t2); }
+	sz index_permissive(sz t1, sz t2) const { return triangular_matrix_index_permissive(num_types, t1, t2); }
 	atom_type::t atom_typing_used() const { return m_atom_typing_used; }
 	fl cutoff_sqr() const { return m_cutoff_sqr; }
 	void widen(fl left, fl right) {
 		flv rs = calculate_rs();
-		VINA_FOR(t1, data.dim())
-			VINA_RANGE(t2, t1, data.dim())
-				data(t1, t2).widen(rs, left, right);
+		VINA_FOR(t1, num_types)
+			VINA_RANGE(t2, t1, num_types)
+				element(triangular_matrix_index(num_types, t1, t2)).widen(rs, left, right);
 	}
 private:
 	flv calculate_rs() const {
@@ -158,12 +160,15 @@ private:
 			tmp[i] = std::sqrt(i / factor);
 		return tmp;
 	}
+	precalculate_element element(sz type_pair_index) { return precalculate_element(&fast[type_pair_index * n], &smooth[type_pair_index * n], n, factor); }
 	fl m_cutoff_sqr;
 	sz n;
 	fl factor;
 	atom_type::t m_atom_typing_used;
+	sz num_types;
 
-	triangular_matrix<precalculate_element> data;
+	std::vector<fl, huge_page_allocator<fl> > fast;   // n for each pair of types
+	std::vector<pr, huge_page_allocator<pr> > smooth; // [(e, dor)], likewise
 };
 
 #endif
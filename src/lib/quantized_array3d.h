@@ -0,0 +1,80 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_QUANTIZED_ARRAY3D_H
+#define VINA_QUANTIZED_ARRAY3D_H
+
+#include <algorithm> // min, max
+#include <boost/cstdint.hpp>
+#include "array3d.h"
+#include "huge_pages.h"
+
+const fl quantized_cap = 100; // kcal/mol; the maps are stored up to this, as the search only needs to know that a clash is bad
+
+class quantized_array3d { // of fl, in 16 bits a value: offset + scale * stored, with the offset and scale chosen for the range of each array
+	sz m_i, m_j, m_k;
+	fl m_offset;
+	fl m_scale; // the resolution
+	std::vector<boost::uint16_t, huge_page_allocator<boost::uint16_t> > m_data;
+public:
+	quantized_array3d() : m_i(0), m_j(0), m_k(0), m_offset(0), m_scale(0) {}
+	template<typename A>
+	explicit quantized_array3d(const array3d<fl, A>& x, fl cap = quantized_cap) : m_i(x.dim0()), m_j(x.dim1()), m_k(x.dim2()), m_offset(0), m_scale(0), m_data(checked_multiply(m_i, m_j, m_k)) { // values above cap are stored as cap
+		if(m_data.empty()) return;
+		fl lo = max_fl;
+		fl hi = -max_fl;
+		VINA_FOR(k, m_k)
+			VINA_FOR(j, m_j)
+				VINA_FOR(i, m_i) {
+					const fl v = x(i, j, k);
+					if(v < lo) lo = v;
+					if(v > hi) hi = v;
+				}
+		if(hi > cap) hi = (std::max)(lo, cap);
+		const fl levels = 65535;
+		m_offset = lo;
+		m_scale = (hi - lo) / levels;
+		const fl factor = (m_scale > 0) ? 1 / m_scale : 0;
+		VINA_FOR(k, m_k)
+			VINA_FOR(j, m_j)
+				VINA_FOR(i, m_i) {
+					const fl v = (std::min)(x(i, j, k), hi);
+					m_data[i + m_i*(j + m_j*k)] = boost::uint16_t((std::min)(levels, (v - lo) * factor + 0.5));
+				}
+	}
+	sz dim0() const { return m_i; }
+	sz dim1() const { return m_j; }
+	sz dim2() const { return m_k; }
+	sz dim(sz i) const {
+		switch(i) {
+			case 0: return m_i;
+			case 1: return m_j;
+			case 2: return m_k;
+			default: assert(false); return 0; // to get rid of the warning
+		}
+	}
+	fl scale() const { return m_scale; }
+	const void* data() const { return m_data.empty() ? NULL : &m_data[0]; }
+	fl operator()(sz i, sz j, sz k) const { return m_offset + m_scale * m_data[i + m_i*(j + m_j*k)]; }
+};
+
+#endif
@@ -28,16 +28,19 @@ struct quasi_newton_aux {
 	const precalculate* p;
 	const igrid* ig;
 	const vec v;
-	quasi_newton_aux(model* m_, const precalculate* p_, const igrid* ig_, const vec& v_) : m(m_), p(p_), ig(ig_), v(v_) {}
+	search_counters* counters;
+	quasi_newton_aux(model* m_, const precalculate* p_, const igrid* ig_, const vec& v_, search_counters* counters_) : m(m_), p(p_), ig(ig_), v(v_), counters(counters_) {}
 	fl operator()(const conf& c, change& g) {
+		if(counters)
+			++counters->evals;
 		const fl tmp = m->eval_deriv(*p, *ig, v, c, g);
 		return tmp;
 	}
 };
 
-void quasi_newton::operator()(model& m, const precalculate& p, const igrid& ig, output_type& out, change& g, const vec& v) const { // g must have correct size
-	quasi_newton_aux aux(&m, &p, &ig, v);
-	fl res = bfgs(aux, out.c, g, max_steps, average_required_improvement, 10);
+void quasi_newton::operator()(model& m, const precalculate& p, const igrid& ig, output_type& out, change& g, const vec& v, search_counters* counters) const { // g must have correct size
+	quasi_newton_aux aux(&m, &p, &ig, v, counters);
+	fl res = bfgs(aux, out.c, g, max_steps, average_required_improvement, 10, counters);
 	out.e = res;
 }
 
@@ -0,0 +1,93 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <sstream>
+#include "receptor_session.h"
+#include "parse_pdbqt.h"
+#include "current_weights.h"
+#include "naive_non_cache.h"
+
+namespace {
+	flv vina_weights() {
+		everything t;
+		return current_weights(t);
+	}
+
+	model parse_receptor(const std::string& pdbqt) { // can throw parse_error
+		return parse_receptor_pdbqt(path("receptor"), pdbqt.data(), pdbqt.data() + pdbqt.size()); // bonded on the calling thread, as dock_params are not known yet
+	}
+
+	model parse_receptor(const std::string& pdbqt, const grid_dims& gd, const flv& weights) { // cropped to gd, as main does it; can throw parse_error
+		everything t;
+		receptor_crop crop(vec(gd[0].begin, gd[1].begin, gd[2].begin), vec(gd[0].end, gd[1].end, gd[2].end), weighted_terms(&t, weights).cutoff());
+		return parse_receptor_pdbqt(path("receptor"), pdbqt.data(), pdbqt.data() + pdbqt.size(), crop);
+	}
+
+	docked_poses split_models(const std::string& pdbqt, const flv& energies) { // write_all_output's MODEL records, one per mode
+		const std::string endmdl("ENDMDL\n");
+		docked_poses tmp;
+		sz begin = 0;
+		VINA_FOR_IN(i, energies) {
+			const sz first = pdbqt.find('\n', begin); // the MODEL line
+			const sz end = pdbqt.find(endmdl, begin);
+			VINA_CHECK(first != std::string::npos && end != std::string::npos && first < end);
+			tmp.push_back(docked_pose(energies[i], pdbqt.substr(first + 1, end - first - 1)));
+			begin = end + endmdl.size();
+		}
+		VINA_CHECK(begin == pdbqt.size());
+		return tmp;
+	}
+}
+
+receptor_session::receptor_session(const std::string& receptor_pdbqt, const grid_dims& gd_)
+	: weights(vina_weights()), gd(gd_), rec(parse_receptor(receptor_pdbqt)), near(parse_receptor(receptor_pdbqt, gd, weights)), setup(weights, gd) {}
+
+receptor_session::receptor_session(const std::string& receptor_pdbqt, const grid_dims& gd_, const flv& weights_)
+	: weights(weights_), gd(gd_), rec(parse_receptor(receptor_pdbqt)), near(parse_receptor(receptor_pdbqt, gd, weights)), setup(weights, gd) {}
+
+model receptor_session::parse_complex(const model& receptor, const std::string& ligand_pdbqt) const {
+	model tmp = receptor;
+	tmp.append(parse_ligand_pdbqt(path("ligand"), ligand_pdbqt.data(), ligand_pdbqt.data() + ligand_pdbqt.size()));
+	return tmp;
+}
+
+docked_poses receptor_session::dock(const std::string& ligand_pdbqt, const dock_params& params) {
+	model m = parse_complex(near, ligand_pdbqt);
+	std::ostringstream out, discard;
+	tee log;
+	log.console = &discard;
+	job_report report;
+	main_procedure(m, boost::optional<model>(), setup, &out,
+				   false, params.local_only, false, false, false, // with the cache
+				   gd, params.exhaustiveness, weights,
+				   params.cpu, params.seed, 0, params.num_modes, params.energy_range, log, report);
+	return split_models(out.str(), report.mode_energies);
+}
+
+fl receptor_session::score(const std::string& pose_pdbqt) {
+	model m = parse_complex(rec, pose_pdbqt);
+	const vec authentic_v(1000, 1000, 1000);
+	const conf c = m.get_initial_conf();
+	const fl intramolecular_energy = m.eval_intramolecular(setup.prec, authentic_v, c);
+	naive_non_cache nnc(&setup.prec); // the pose need not be within the search space
+	return m.eval_adjusted(setup.wt, setup.prec, nnc, authentic_v, c, intramolecular_energy);
+}
@@ -0,0 +1,75 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_RECEPTOR_SESSION_H
+#define VINA_RECEPTOR_SESSION_H
+
+#include <string>
+#include <vector>
+#include <boost/utility.hpp> // for noncopyable
+#include "docking.h"
+#include "parse_error.h"
+
+// vina for use from other programs: the receptor is parsed and the scoring set up once, and then ligands are docked or poses scored
+// from PDBQT text in memory, without files or a log; the grids of the atom types seen so far are kept for the later ligands.
+// As in vina, dock uses only the receptor atoms near the search space (see receptor_crop), while score, which does not confine the pose,
+// uses all of them, so the receptor is kept both ways
+
+struct dock_params {
+	int exhaustiveness;
+	int seed;
+	int cpu;
+	sz num_modes;
+	fl energy_range; // kcal/mol
+	bool local_only; // only a local optimization of the given pose, which becomes the one mode
+	dock_params() : exhaustiveness(8), seed(0), cpu(1), num_modes(9), energy_range(3), local_only(false) {}
+};
+
+struct docked_pose {
+	fl energy; // kcal/mol
+	std::string pdbqt; // what is within MODEL and ENDMDL in vina's output; dock and score take it as a ligand
+	docked_pose(fl energy_, const std::string& pdbqt_) : energy(energy_), pdbqt(pdbqt_) {}
+};
+typedef std::vector<docked_pose> docked_poses;
+
+struct receptor_session : private boost::noncopyable { // dock and score are not to be called from several threads at once
+	receptor_session(const std::string& receptor_pdbqt, const grid_dims& gd); // with vina's weights; can throw parse_error
+	receptor_session(const std::string& receptor_pdbqt, const grid_dims& gd, const flv& weights); // can throw parse_error
+
+	docked_poses dock (const std::string& ligand_pdbqt, const dock_params& params); // the best first; can throw parse_error
+	fl           score(const std::string& pose_pdbqt); // of the pose as it is, like --score_only; can throw parse_error
+
+	void set_grid_storage(grid_storage storage) { setup.c.set_storage(storage); } // of the grids computed from then on
+
+	const model& receptor() const { return rec; }
+	const grid_dims& space() const { return gd; }
+private:
+	model parse_complex(const model& receptor, const std::string& ligand_pdbqt) const; // can throw parse_error
+
+	flv weights;
+	grid_dims gd;
+	model rec;  // whole, for score
+	model near; // cropped to gd, for dock
+	scoring_setup setup;
+};
+
+#endif
@@ -0,0 +1,93 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <cstring> // memcpy, memcmp
+#include <boost/crc.hpp>
+#include "receptor_snapshot.h"
+#include "file.h"
+#include "mapped_file.h"
+#include "compressed_file.h"
+
+namespace {
+	const char snapshot_magic[8] = {'V', 'I', 'N', 'A', 'R', 'E', 'C', '\n'};
+	const boost::uint32_t snapshot_version = 1;
+
+	struct snapshot_header {
+		char magic[8];
+		boost::uint32_t version;
+		boost::uint16_t fl_size;
+		boost::uint16_t sz_size;
+		boost::uint64_t size; // of the contents, which follow the header
+		boost::uint32_t checksum; // CRC-32 of the contents
+		boost::uint32_t unused;
+		snapshot_header(boost::uint64_t size_, boost::uint32_t checksum_) : version(snapshot_version), fl_size(sizeof(fl)), sz_size(sizeof(sz)), size(size_), checksum(checksum_), unused(0) {
+			std::memcpy(magic, snapshot_magic, sizeof(magic));
+		}
+	};
+
+	boost::uint32_t checksum(const char* begin, const char* end) {
+		boost::crc_32_type crc;
+		crc.process_block(begin, end);
+		return crc.checksum();
+	}
+}
+
+bool is_receptor_snapshot(const path& name) {
+	izfile in(name); // a compressed snapshot is read through mapped_file as well
+	char magic[sizeof(snapshot_magic)];
+	return in.read(magic, sizeof(magic)) && std::memcmp(magic, snapshot_magic, sizeof(magic)) == 0;
+}
+
+void write_receptor_snapshot(const path& name, const model& m) {
+	std::string contents;
+	flat_oarchive ar(contents);
+	ar & m;
+	const snapshot_header h(contents.size(), checksum(contents.data(), contents.data() + contents.size()));
+	ofile out(name, std::ios::binary);
+	out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	out.write(contents.data(), contents.size());
+	out.close();
+	if(!out)
+		throw file_error(name, false);
+}
+
+model read_receptor_snapshot(const path& name) {
+	mapped_file f(name);
+	snapshot_header h(0, 0);
+	if(f.size() < sizeof(h) || std::memcmp(f.data(), snapshot_magic, sizeof(snapshot_magic)) != 0)
+		throw archive_error(name, "not a receptor snapshot");
+	std::memcpy(&h, f.data(), sizeof(h)); // the mapping need not be aligned for it
+	if(h.version != snapshot_version || h.fl_size != sizeof(fl) || h.sz_size != sizeof(sz))
+		throw archive_error(name, "written by a different version of vina_prepare, or on a different kind of machine");
+	const char* begin = f.data() + sizeof(h);
+	if(h.size != boost::uint64_t(f.end() - begin))
+		throw archive_error(name, "the file is truncated");
+	if(h.checksum != checksum(begin, f.end()))
+		throw archive_error(name, "the checksum does not match - the file is corrupt");
+	try {
+		flat_iarchive ar(begin, f.end());
+		return ar.load_model();
+	}
+	catch(flat_archive_error&) {
+		throw archive_error(name, "the contents are corrupt");
+	}
+}
@@ -0,0 +1,36 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_RECEPTOR_SNAPSHOT_H
+#define VINA_RECEPTOR_SNAPSHOT_H
+
+#include "flat_archive.h"
+
+// a receptor as parse_receptor_pdbqt returns it - typed and bonded, with the flexible side chains, if any -
+// saved by vina_prepare --receptor, so that runs against the same receptor skip the parsing and bond perception
+// the contents are checksummed, and like ligand archives (see ligand_archive.h), the encoding is native
+
+bool is_receptor_snapshot(const path& name); // from the magic bytes; can throw file_error, compression_error
+void write_receptor_snapshot(const path& name, const model& m); // can throw file_error
+model read_receptor_snapshot(const path& name); // can throw file_error, compression_error, archive_error
+
+#endif
@@ -0,0 +1,57 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_SEARCH_COUNTERS_H
+#define VINA_SEARCH_COUNTERS_H
+
+#include <vector>
+#include "common.h"
+#include "instrument.h"
+
+struct search_counters { // kept by the thread doing the work, without any locking, and added up afterwards
+	unsigned long evals;              // of the energy and its gradient
+	unsigned long bfgs_steps;
+	unsigned long line_search_trials;
+	unsigned long mc_steps;
+	unsigned long mc_accepted;
+	search_counters() : evals(0), bfgs_steps(0), line_search_trials(0), mc_steps(0), mc_accepted(0) {}
+	search_counters& operator+=(const search_counters& x) {
+		evals              += x.evals;
+		bfgs_steps         += x.bfgs_steps;
+		line_search_trials += x.line_search_trials;
+		mc_steps           += x.mc_steps;
+		mc_accepted        += x.mc_accepted;
+		return *this;
+	}
+	fl mc_acceptance_rate() const { return (mc_steps > 0) ? fl(mc_accepted) / mc_steps : 0; }
+};
+
+struct search_stats { // of a parallel search
+	search_counters counters; // over all the tasks
+	flv thread_busy;          // seconds each thread spent running tasks
+	instrument_counts instrument; // over all the tasks, if instrumentation is on
+	sz local_tasks;           // that read grids on the NUMA node of their thread (see locality.h)
+	sz remote_tasks;          // that read grids on another node; neither, if it is not known
+	search_stats() : local_tasks(0), remote_tasks(0) {}
+};
+
+#endif
@@ -0,0 +1,90 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <iomanip>
+#include "server.h"
+
+namespace {
+	bool read_line(std::istream& in, std::string& line) { // without the CR of CRLF
+		if(!std::getline(in, line)) return false;
+		if(!line.empty() && line[line.size() - 1] == '\r')
+			line.resize(line.size() - 1);
+		return true;
+	}
+}
+
+bool read_server_job(std::istream& in, server_job& job) {
+	std::string line;
+	while(read_line(in, line)) {
+		std::istringstream fields(line);
+		std::string command;
+		if(!(fields >> command)) continue; // blank
+		if(command == "QUIT") return false;
+		job = server_job();
+		fields >> job.id;
+		if(command == "LIGAND") { // the body is read even without an id, so that its lines are not taken for jobs
+			bool ended = false;
+			while(!ended && read_line(in, line)) {
+				if(line == "END_LIGAND")
+					ended = true;
+				else {
+					job.pdbqt += line;
+					job.pdbqt += '\n';
+				}
+			}
+			if(!ended)
+				job.error = "the input ended before END_LIGAND";
+		}
+		else if(command == "FILE") {
+			std::string name;
+			std::getline(fields >> std::ws, name); // may have spaces
+			if(name.empty())
+				job.error = "missing file name";
+			else
+				job.file = path(name);
+		}
+		else
+			job.error = "unknown command " + command;
+		if(job.id.empty()) {
+			job.id = "-";
+			job.error = "missing job id";
+		}
+		return true;
+	}
+	return false;
+}
+
+void write_server_result(std::ostream& out, const std::string& id, const flv& energies, const std::string& pdbqt) {
+	out << "RESULT " << id << ' ' << energies.size();
+	out << std::fixed << std::setprecision(3);
+	VINA_FOR_IN(i, energies)
+		out << ' ' << energies[i];
+	out.unsetf(std::ios::floatfield);
+	out << '\n' << pdbqt << "END_RESULT\n" << std::flush;
+}
+
+void write_server_error(std::ostream& out, const std::string& id, const std::string& message) {
+	out << "ERROR " << id << ' ' << message << '\n' << std::flush;
+}
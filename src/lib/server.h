@@ -0,0 +1,53 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_SERVER_H
+#define VINA_SERVER_H
+
+#include <iosfwd>
+#include <string>
+#include "common.h"
+
+// the line protocol of vina --server, which sets up the receptor, the search space and the scoring once,
+// and then docks the ligands it is given, one after another, keeping the grids of the atom types seen so far
+//
+// jobs, on stdin:
+//   LIGAND <id>         followed by the ligand's PDBQT lines, and END_LIGAND
+//   FILE <id> <path>    a ligand file (PDBQT, possibly compressed), read by the server
+//   QUIT                or the end of the input, stops the server
+// answers, on stdout, one per job and in order:
+//   RESULT <id> <number of modes> <their energies, kcal/mol>   followed by the modes (PDBQT), and END_RESULT
+//   ERROR <id> <message>
+// the log goes to stderr
+
+struct server_job {
+	std::string id;
+	path file;          // for FILE
+	std::string pdbqt;  // for LIGAND
+	std::string error;  // if the request itself was wrong; the job is answered with it
+};
+
+bool read_server_job(std::istream& in, server_job& job); // false at QUIT or at the end of the input
+void write_server_result(std::ostream& out, const std::string& id, const flv& energies, const std::string& pdbqt); // flushes
+void write_server_error (std::ostream& out, const std::string& id, const std::string& message); // flushes
+
+#endif
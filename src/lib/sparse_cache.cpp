@@ -0,0 +1,203 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <algorithm> // fill
+#include "sparse_cache.h"
+#include "brick.h"
+#include "instrument.h"
+
+void brick_array3d::resize(sz i, sz j, sz k) {
+	clear();
+	m_i = i;
+	m_j = j;
+	m_k = k;
+	m_bi = (i + brick_size - 1) >> brick_bits;
+	m_bj = (j + brick_size - 1) >> brick_bits;
+	m_bk = (k + brick_size - 1) >> brick_bits;
+	const sz n = checked_multiply(m_bi, m_bj, m_bk);
+	bricks.reset(new boost::atomic<const fl*>[n]);
+	VINA_FOR(b, n)
+		bricks[b].store(NULL, boost::memory_order_relaxed);
+}
+
+const fl* brick_array3d::fill(sz b) const {
+	assert(owner);
+	return owner->fill(type, b);
+}
+
+void brick_array3d::clear() {
+	if(!bricks) return;
+	VINA_FOR(b, m_bi * m_bj * m_bk) {
+		const fl* values = bricks[b].load(boost::memory_order_relaxed);
+		if(values != owner->zeros.get())
+			delete[] values;
+	}
+	bricks.reset();
+}
+
+sparse_cache::sparse_cache(const grid_dims& gd_, fl slope_, atom_type::t atom_typing_used_)
+: gd(gd_), slope(slope_), atu(atom_typing_used_), p(NULL), zeros(new fl[brick_array3d::brick_points]), computed(0) {
+	std::fill(zeros.get(), zeros.get() + brick_array3d::brick_points, 0);
+	VINA_FOR(t, num_atom_types(atu)) {
+		grids.push_back(new sparse_grid);
+		grids.back().m_data.owner = this;
+		grids.back().m_data.type = t;
+	}
+}
+
+fl sparse_cache::eval      (const model& m, fl v) const { // needs m.coords
+	fl e = 0;
+	sz nat = num_atom_types(atu);
+
+	VINA_FOR(i, m.num_movable_atoms()) {
+		const atom& a = m.atoms[i];
+		sz t = a.get(atu);
+		if(t >= nat) continue;
+		const sparse_grid& g = grids[t];
+		assert(g.initialized());
+		e += g.evaluate(m.coords[i], slope, v);
+	}
+	return e;
+}
+
+fl sparse_cache::eval_deriv(      model& m, fl v) const { // needs m.coords, sets m.minus_forces
+	VINA_INSTRUMENT_SCOPE(INSTRUMENT_GRID_EVAL_DERIV);
+	fl e = 0;
+	sz nat = num_atom_types(atu);
+
+	VINA_FOR(i, m.num_movable_atoms()) {
+		const atom& a = m.atoms[i];
+		sz t = a.get(atu);
+		if(t >= nat) { m.minus_forces[i].assign(0); continue; }
+		const sparse_grid& g = grids[t];
+		assert(g.initialized());
+		vec deriv;
+		e += g.evaluate(m.coords[i], slope, v, deriv);
+		m.minus_forces[i] = deriv;
+	}
+	return e;
+}
+
+void sparse_cache::populate(const model& m, const precalculate& p_, const szv& atom_types_needed) {
+	p = &p_;
+	const sz nat = num_atom_types(atu);
+	vec begin, end;
+	VINA_FOR_IN(i, gd) {
+		begin[i] = gd[i].begin;
+		end  [i] = gd[i].end;
+	}
+	atoms.clear(); // in the order of m.grid_atoms, so that the sums come out as in cache
+	VINA_FOR_IN(i, m.grid_atoms) {
+		const atom& a = m.grid_atoms[i];
+		if(a.get(atu) < nat && brick_distance_sqr(begin, end, a.coords) < p->cutoff_sqr())
+			atoms.push_back(a);
+	}
+	VINA_FOR_IN(i, atom_types_needed) {
+		sz t = atom_types_needed[i];
+		if(!grids[t].initialized())
+			grids[t].init(gd);
+	}
+}
+
+sz sparse_cache::bricks_computed() const {
+	return computed.load(boost::memory_order_relaxed);
+}
+
+sz sparse_cache::bricks_total() const {
+	sz tmp = 0;
+	VINA_FOR_IN(t, grids) {
+		const brick_array3d& d = grids[t].m_data;
+		tmp += d.m_bi * d.m_bj * d.m_bk;
+	}
+	return tmp;
+}
+
+const fl* sparse_cache::fill(sz type, sz b) const {
+	boost::mutex::scoped_lock lk(locks[b % num_locks]);
+	{
+		const fl* tmp = grids[type].m_data.bricks[b].load(boost::memory_order_relaxed);
+		if(tmp) return tmp; // computed while this thread waited
+	}
+	assert(p);
+
+	szv needed;
+	VINA_FOR_IN(t, grids)
+		if(grids[t].initialized() && !grids[t].m_data.bricks[b].load(boost::memory_order_relaxed))
+			needed.push_back(t);
+
+	const sparse_grid& g = grids[type];
+	const brick_array3d& d = g.m_data;
+	const sz S = brick_array3d::brick_size;
+	const sz x_begin = S * (b % d.m_bi);
+	const sz y_begin = S * (b / d.m_bi % d.m_bj);
+	const sz z_begin = S * (b / d.m_bi / d.m_bj);
+	const sz x_end = (std::min)(x_begin + S, d.m_i);
+	const sz y_end = (std::min)(y_begin + S, d.m_j);
+	const sz z_end = (std::min)(z_begin + S, d.m_k);
+
+	const fl cutoff_sqr = p->cutoff_sqr();
+	const vec corner1 = g.index_to_argument(x_begin,   y_begin,   z_begin);
+	const vec corner2 = g.index_to_argument(x_end - 1, y_end - 1, z_end - 1);
+	szv possibilities;
+	VINA_FOR_IN(i, atoms)
+		if(brick_distance_sqr(corner1, corner2, atoms[i].coords) < cutoff_sqr)
+			possibilities.push_back(i);
+	if(possibilities.empty()) { // nothing in reach, as in much of a box for blind docking
+		VINA_FOR_IN(j, needed)
+			grids[needed[j]].m_data.bricks[b].store(zeros.get(), boost::memory_order_release);
+		return zeros.get();
+	}
+
+	std::vector<fl*> values(needed.size());
+	VINA_FOR_IN(j, needed) {
+		values[j] = new fl[brick_array3d::brick_points];
+		std::fill(values[j], values[j] + brick_array3d::brick_points, 0);
+	}
+
+	const sz nat = num_atom_types(atu);
+	for(sz x = x_begin; x < x_end; ++x) {
+		for(sz y = y_begin; y < y_end; ++y) {
+			for(sz z = z_begin; z < z_end; ++z) {
+				vec probe_coords; probe_coords = g.index_to_argument(x, y, z);
+				const sz local = (x - x_begin) + S * ((y - y_begin) + S * (z - z_begin));
+				VINA_FOR_IN(possibilities_i, possibilities) {
+					const atom& a = atoms[possibilities[possibilities_i]];
+					const sz t1 = a.get(atu);
+					const fl r2 = vec_distance_sqr(a.coords, probe_coords);
+					if(r2 <= cutoff_sqr) {
+						VINA_FOR_IN(j, needed) {
+							const sz t2 = needed[j];
+							assert(t2 < nat);
+							const sz type_pair_index = triangular_matrix_index_permissive(nat, t1, t2);
+							values[j][local] += p->eval_fast(type_pair_index, r2);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	VINA_FOR_IN(j, needed)
+		grids[needed[j]].m_data.bricks[b].store(values[j], boost::memory_order_release);
+	computed.fetch_add(needed.size(), boost::memory_order_relaxed);
+	return grids[type].m_data.bricks[b].load(boost::memory_order_relaxed);
+}
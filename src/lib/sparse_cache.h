@@ -0,0 +1,103 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_SPARSE_CACHE_H
+#define VINA_SPARSE_CACHE_H
+
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/utility.hpp> // for noncopyable
+#include "igrid.h"
+#include "grid.h"
+#include "model.h"
+#include "precalculate.h"
+
+// the maps of cache, for boxes much larger than the ligand (blind docking): nothing is computed by populate,
+// and each brick of brick_size^3 points is computed for all the atom types in use the first time any thread reads it,
+// so that the memory and the time taken follow the volume explored rather than the size of the box;
+// the bricks beyond the cutoff of every receptor atom, which are all zeros, share one array instead
+
+struct sparse_cache;
+
+class brick_array3d : private boost::noncopyable { // the data of one map of sparse_cache, as basic_grid reads it
+public:
+	enum { brick_bits = 3, brick_size = 1 << brick_bits, brick_points = brick_size * brick_size * brick_size }; // 3 A at the usual spacing
+	brick_array3d() : m_i(0), m_j(0), m_k(0), m_bi(0), m_bj(0), m_bk(0), owner(NULL), type(0) {}
+	~brick_array3d() { clear(); }
+	sz dim0() const { return m_i; }
+	sz dim1() const { return m_j; }
+	sz dim2() const { return m_k; }
+	sz dim(sz i) const {
+		switch(i) {
+			case 0: return m_i;
+			case 1: return m_j;
+			case 2: return m_k;
+			default: assert(false); return 0; // to get rid of the warning
+		}
+	}
+	void resize(sz i, sz j, sz k); // drops the bricks
+	fl operator()(sz i, sz j, sz k) const {
+		const sz b = (i >> brick_bits) + m_bi * ((j >> brick_bits) + m_bj * (k >> brick_bits));
+		const fl* values = bricks[b].load(boost::memory_order_acquire);
+		if(!values)
+			values = fill(b);
+		const sz mask = brick_size - 1;
+		return values[(i & mask) + brick_size * ((j & mask) + brick_size * (k & mask))];
+	}
+private:
+	sz m_i, m_j, m_k;    // points
+	sz m_bi, m_bj, m_bk; // bricks
+	boost::scoped_array<boost::atomic<const fl*> > bricks; // owned; NULL until computed
+	const sparse_cache* owner;
+	sz type;
+	const fl* fill(sz b) const;
+	void clear();
+	friend struct sparse_cache;
+};
+
+typedef basic_grid<brick_array3d> sparse_grid;
+
+struct sparse_cache : public igrid, private boost::noncopyable {
+	sparse_cache(const grid_dims& gd_, fl slope_, atom_type::t atom_typing_used_);
+	fl eval      (const model& m, fl v) const; // needs m.coords
+	fl eval_deriv(      model& m, fl v) const; // needs m.coords, sets m.minus_forces
+	void populate(const model& m, const precalculate& p, const szv& atom_types_needed); // only takes note of the receptor and of the atom types; p must outlive the searches
+	sz bricks_computed() const; // stored, over all the atom types; not those that share the zeros
+	sz bricks_total() const;    // if the maps of the atom types so far were computed in full
+private:
+	grid_dims gd;
+	fl slope;
+	atom_type::t atu;
+	const precalculate* p;
+	atomv atoms; // of the receptor, near enough to the box to count
+	boost::scoped_array<fl> zeros; // a brick of them; declared before grids, which point to it
+	boost::ptr_vector<sparse_grid> grids; // by atom type; initialized once needed
+	mutable boost::atomic<sz> computed; // bricks
+	enum { num_locks = 64 };
+	mutable boost::mutex locks[num_locks]; // computing brick b should lock locks[b % num_locks] first, so that threads compute different bricks at once
+	const fl* fill(sz type, sz b) const; // computes brick b of all the maps that lack it, unless another thread just did
+	friend class brick_array3d;
+};
+
+#endif
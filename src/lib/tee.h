@@ -24,42 +24,62 @@
 #define VINA_TEE_H
 
 #include <iostream>
+#include <boost/scoped_ptr.hpp>
 #include "file.h"
+#include "async_writer.h"
 
 struct tee {
 	ofile* of;
-	tee() : of(NULL) {}
+	std::ostream* console; // std::cout (std::cerr when stdout is taken), or what passes the text on to it
+	std::ostream* log;     // of, likewise
+	tee() : of(NULL), console(&std::cout), log(NULL) {}
 	void init(const path& name) {
 		of = new ofile(name);
+		log = of;
+	}
+	void init(async_writer& w) { // from now on, the writing is left to w; w should outlive this
+		async_console.reset(new async_ostream(w, *console));
+		console = async_console.get();
+		if(of) {
+			async_log.reset(new async_ostream(w, *of));
+			log = async_log.get();
+		}
+	}
+	virtual ~tee() {
+		async_console.reset(); // waits for the writer
+		async_log.reset();
+		delete of;
 	}
-	virtual ~tee() { delete of; }
 	void flush() {
-		std::cout << std::flush;
-		if(of)
-			(*of) << std::flush;
+		(*console) << std::flush;
+		if(log)
+			(*log) << std::flush;
 	}
 	void endl() {
-		std::cout << std::endl;
-		if(of)
-			(*of) << std::endl;
+		(*console) << std::endl;
+		if(log)
+			(*log) << std::endl;
 	}
 	void setf(std::ios::fmtflags a) {
-		std::cout.setf(a);
-		if(of)
-			of->setf(a);
+		console->setf(a);
+		if(log)
+			log->setf(a);
 	}
 	void setf(std::ios::fmtflags a, std::ios::fmtflags b) {
-		std::cout.setf(a, b);
-		if(of)
-			of->setf(a, b);
+		console->setf(a, b);
+		if(log)
+			log->setf(a, b);
 	}
+private:
+	boost::scoped_ptr<async_ostream> async_console;
+	boost::scoped_ptr<async_ostream> async_log;
 };
 
 template<typename T>
 tee& operator<<(tee& out, const T& x) {
-	std::cout << x;
-	if(out.of)
-		(*out.of) << x;
+	(*out.console) << x;
+	if(out.log)
+		(*out.log) << x;
 	return out;
 }
 
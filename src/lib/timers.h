@@ -0,0 +1,62 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_TIMERS_H
+#define VINA_TIMERS_H
+
+#include <ctime>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include "common.h"
+
+struct wall_timer { // boost::timer measures CPU time, which is not what the throughput is about
+	wall_timer() : start(now()) {}
+	fl elapsed() const { return fl((now() - start).total_microseconds()) / 1e6; }
+private:
+	static boost::posix_time::ptime now() { return boost::posix_time::microsec_clock::universal_time(); }
+	boost::posix_time::ptime start;
+};
+
+struct phase_time {
+	fl wall;
+	fl cpu; // of the whole process, so with several threads it can exceed wall
+	phase_time() : wall(0), cpu(0) {}
+	phase_time& operator+=(const phase_time& x) {
+		wall += x.wall;
+		cpu  += x.cpu;
+		return *this;
+	}
+};
+
+struct phase_timer {
+	phase_timer() : cpu_start(std::clock()) {}
+	phase_time elapsed() const {
+		phase_time tmp;
+		tmp.wall = w.elapsed();
+		tmp.cpu  = fl(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+		return tmp;
+	}
+private:
+	wall_timer w;
+	std::clock_t cpu_start;
+};
+
+#endif
@@ -0,0 +1,191 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <ostream>
+#include <cstring> // strcmp
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include "trace.h"
+#include "my_pid.h"
+
+namespace {
+	struct trace_event {
+		const char* category;
+		const char* name;
+		sz index;
+		bool has_index;
+		sz thread;
+		boost::int64_t start;    // microseconds since start_tracing()
+		boost::int64_t duration; // microseconds
+	};
+
+	struct trace_state {
+		boost::mutex self;
+		boost::posix_time::ptime origin;
+		std::vector<trace_event> events; // not written yet
+		szv free_numbers;                // of the threads that have exited
+		sz num_numbers;                  // given out so far
+		sz num_named;                    // threads whose names have been written
+		bool opened;                     // the array has been started
+		bool empty;                      // nothing in the array yet
+		bool on;                         // between start_tracing() and stop_tracing()
+		trace_state() : origin(boost::posix_time::microsec_clock::universal_time()), num_numbers(0), num_named(0), opened(false), empty(true), on(false) {}
+	};
+
+	trace_state* state = NULL; // never freed: the exiting threads give their numbers back to it, even late
+
+	void release_number(sz* number) {
+		{
+			boost::mutex::scoped_lock self_lk(state->self);
+			state->free_numbers.push_back(*number);
+		}
+		delete number;
+	}
+
+	boost::thread_specific_ptr<sz> thread_number(release_number);
+
+	sz current_thread_number() { // state->self is locked
+		if(!thread_number.get()) {
+			sz n = state->num_numbers;
+			if(state->free_numbers.empty())
+				++state->num_numbers;
+			else {
+				n = state->free_numbers.back();
+				state->free_numbers.pop_back();
+			}
+			thread_number.reset(new sz(n));
+		}
+		return *thread_number;
+	}
+
+	boost::int64_t now() {
+		return (boost::posix_time::microsec_clock::universal_time() - state->origin).total_microseconds();
+	}
+
+	void write_element(std::ostream& out, trace_state& s) { // the separator before the next element
+		out << (s.empty ? "\n" : ",\n");
+		s.empty = false;
+	}
+}
+
+void start_tracing() {
+	if(!state)
+		state = new trace_state;
+	boost::mutex::scoped_lock self_lk(state->self);
+	if(state->on) return;
+	state->on = true;
+	current_thread_number(); // 0, the first time
+}
+
+void stop_tracing() {
+	if(!state) return;
+	boost::mutex::scoped_lock self_lk(state->self);
+	state->on = false;
+	state->events.clear();
+	state->origin = boost::posix_time::microsec_clock::universal_time();
+	state->num_named = 0;
+	state->opened = false;
+	state->empty = true;
+}
+
+bool tracing_enabled() {
+	return state && state->on;
+}
+
+void write_trace(std::ostream& out) {
+	if(!tracing_enabled()) return;
+	std::vector<trace_event> tmp;
+	sz named_from, named_to;
+	{
+		boost::mutex::scoped_lock self_lk(state->self);
+		tmp.swap(state->events);
+		named_from = state->num_named;
+		named_to = state->num_numbers;
+		state->num_named = named_to;
+	}
+	const int pid = my_pid();
+	if(!state->opened) {
+		out << '[';
+		state->opened = true;
+	}
+	for(sz i = named_from; i < named_to; ++i) {
+		write_element(out, *state);
+		out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << i << ", \"args\": {\"name\": \"";
+		if(i == 0) out << "main";
+		else       out << "thread " << i;
+		out << "\"}}";
+	}
+	VINA_FOR_IN(i, tmp) {
+		const trace_event& e = tmp[i];
+		write_element(out, *state);
+		out << "{\"name\": \"" << e.name << "\", \"cat\": \"" << e.category << "\", \"ph\": \"X\", \"pid\": " << pid << ", \"tid\": " << e.thread
+		    << ", \"ts\": " << e.start << ", \"dur\": " << e.duration;
+		if(e.has_index)
+			out << ", \"args\": {\"index\": " << e.index << '}';
+		out << '}';
+	}
+}
+
+void end_trace(std::ostream& out) {
+	if(!tracing_enabled()) return;
+	write_trace(out);
+	out << "\n]\n";
+}
+
+fl traced_seconds(const char* name) {
+	if(!tracing_enabled()) return 0;
+	boost::int64_t tmp = 0;
+	boost::mutex::scoped_lock self_lk(state->self);
+	VINA_FOR_IN(i, state->events)
+		if(std::strcmp(state->events[i].name, name) == 0)
+			tmp += state->events[i].duration;
+	return fl(tmp) / 1e6;
+}
+
+void discard_trace() {
+	if(!tracing_enabled()) return;
+	boost::mutex::scoped_lock self_lk(state->self);
+	state->events.clear();
+}
+
+trace_span::trace_span(const char* category_, const char* name_)
+	: category(category_), name(name_), index(0), has_index(false), on(tracing_enabled()), start(on ? now() : 0) {}
+
+trace_span::trace_span(const char* category_, const char* name_, sz index_)
+	: category(category_), name(name_), index(index_), has_index(true), on(tracing_enabled()), start(on ? now() : 0) {}
+
+void trace_span::end() {
+	if(!on) return;
+	on = false;
+	trace_event e;
+	e.category = category;
+	e.name = name;
+	e.index = index;
+	e.has_index = has_index;
+	e.start = start;
+	e.duration = now() - start;
+	boost::mutex::scoped_lock self_lk(state->self);
+	e.thread = current_thread_number();
+	state->events.push_back(e);
+}
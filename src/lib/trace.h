@@ -0,0 +1,77 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#ifndef VINA_TRACE_H
+#define VINA_TRACE_H
+
+#include <iosfwd>
+#include <boost/cstdint.hpp>
+#include "common.h"
+#include "timers.h"
+
+// a timeline of the phases and of what each thread did, in the Chrome trace event format,
+// for chrome://tracing or ui.perfetto.dev
+//
+// Nothing is recorded until start_tracing(), or after stop_tracing(). In between, each trace_span becomes one complete event
+// when it ends. The spans are coarse (phases, Monte Carlo tasks, refinements, waits in the thread pools),
+// so the events are collected under a mutex. Threads are numbered from 0 (the one that started tracing),
+// and the numbers of the threads that have exited are reused, so that each pool shows up on the same rows.
+
+void start_tracing(); // before starting the threads
+void stop_tracing();  // after they are done; what was not written is dropped, and a later start_tracing() begins a new timeline
+bool tracing_enabled();
+
+// the events since the last call, as the next elements of a JSON array that is opened by the first call;
+// the viewers accept the array without its closing bracket, so a partial trace is still usable
+void write_trace(std::ostream& out);
+void end_trace(std::ostream& out); // the remaining events, and the closing bracket
+
+// for the benchmarks: the total duration, in seconds, of the events with this name recorded since they were last written or discarded
+fl traced_seconds(const char* name);
+void discard_trace();
+
+struct trace_span {
+	trace_span(const char* category_, const char* name_);
+	trace_span(const char* category_, const char* name_, sz index_); // the index goes into the event's args
+	~trace_span() { end(); }
+	void end(); // before the end of the scope; only the first call counts
+private:
+	const char* category;
+	const char* name;
+	sz index;
+	bool has_index;
+	bool on;
+	boost::int64_t start;
+};
+
+struct traced_phase { // a phase_timer that also shows up on the timeline
+	traced_phase(const char* name) : span("phase", name) {}
+	phase_time end() {
+		span.end();
+		return timer.elapsed();
+	}
+private:
+	phase_timer timer;
+	trace_span span;
+};
+
+#endif
@@ -27,6 +27,7 @@
 #include "atom.h"
 
 struct frame {
+	frame() {} // for deserialization
 	frame(const vec& origin_) : origin(origin_), orientation_q(qt_identity), orientation_m(quaternion_to_r3(qt_identity)) {}
 	vec local_to_lab(const vec& local_coords) const {
 		vec tmp;
@@ -48,11 +49,20 @@ protected:
 	}
 	mat orientation_m;
 	qt  orientation_q;
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & origin;
+		ar & orientation_m;
+		ar & orientation_q;
+	}
 };
 
 struct atom_range {
     sz begin;
     sz end;
+	atom_range() : begin(0), end(0) {}
 	atom_range(sz begin_, sz end_) : begin(begin_), end(end_) {}
 	template<typename F>
 	void transform(const F& f) {
@@ -60,9 +70,17 @@ struct atom_range {
 		begin = f(begin);
 		end   = begin + diff;
 	}
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & begin;
+		ar & end;
+	}
 };
 
 struct atom_frame : public frame, public atom_range {
+	atom_frame() {}
 	atom_frame(const vec& origin_, sz begin_, sz end_) : frame(origin_), atom_range(begin_, end_) {}
 	void set_coords(const atomv& atoms, vecv& coords) const {
 		VINA_RANGE(i, begin, end)
@@ -78,9 +96,17 @@ struct atom_frame : public frame, public atom_range {
 		}
 		return tmp;
 	}
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & boost::serialization::base_object<frame>(*this);
+		ar & boost::serialization::base_object<atom_range>(*this);
+	}
 };
 
 struct rigid_body : public atom_frame {
+	rigid_body() {}
 	rigid_body(const vec& origin_, sz begin_, sz end_) : atom_frame(origin_, begin_, end_) {}
 	void set_conf(const atomv& atoms, vecv& coords, const rigid_conf& c) {
 		origin = c.position;
@@ -92,9 +118,16 @@ struct rigid_body : public atom_frame {
 		c.position     = force_torque.first;
 		c.orientation  = force_torque.second;
 	}
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & boost::serialization::base_object<atom_frame>(*this);
+	}
 };
 
 struct axis_frame : public atom_frame {
+	axis_frame() {}
 	axis_frame(const vec& origin_, sz begin_, sz end_, const vec& axis_root) : atom_frame(origin_, begin_, end_) {
 		vec diff; diff = origin - axis_root;
 		fl nrm = diff.norm();
@@ -106,9 +139,17 @@ struct axis_frame : public atom_frame {
 	}
 protected:
 	vec axis;
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & boost::serialization::base_object<atom_frame>(*this);
+		ar & axis;
+	}
 };
 
 struct segment : public axis_frame {
+	segment() {}
 	segment(const vec& origin_, sz begin_, sz end_, const vec& axis_root, const frame& parent) : axis_frame(origin_, begin_, end_, axis_root) {
 		VINA_CHECK(eq(parent.orientation(), qt_identity)); // the only initial parent orientation this c'tor supports
 		relative_axis = axis;
@@ -131,9 +172,17 @@ struct segment : public axis_frame {
 private:
 	vec relative_axis;
 	vec relative_origin;
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & boost::serialization::base_object<axis_frame>(*this);
+		ar & relative_axis;
+		ar & relative_origin;
+	}
 };
 
 struct first_segment : public axis_frame {
+	first_segment() {}
 	first_segment(const segment& s) : axis_frame(s) {}
 	first_segment(const vec& origin_, sz begin_, sz end_, const vec& axis_root) : axis_frame(origin_, begin_, end_, axis_root) {}
 	void set_conf(const atomv& atoms, vecv& coords, fl torsion) {
@@ -143,6 +192,12 @@ struct first_segment : public axis_frame {
 	void count_torsions(sz& s) const {
 		++s;
 	}
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & boost::serialization::base_object<axis_frame>(*this);
+	}
 };
 
 template<typename T> // T == branch
@@ -165,6 +220,7 @@ template<typename T> // T == segment
 struct tree {
 	T node;
 	std::vector< tree<T> > children;
+	tree() {}
 	tree(const T& node_) : node(node_) {}
 	void set_conf(const frame& parent, const atomv& atoms, vecv& coords, flv::const_iterator& c) {
 		node.set_conf(parent, atoms, coords, c);
@@ -178,6 +234,13 @@ struct tree {
 		node.set_derivative(force_torque, d);
 		return force_torque;
 	}
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & node;
+		ar & children;
+	}
 };
 
 typedef tree<segment> branch;
@@ -187,6 +250,7 @@ template<typename Node> // Node == first_segment || rigid_body
 struct heterotree {
 	Node node;
 	branches children;
+	heterotree() {}
 	heterotree(const Node& node_) : node(node_) {}
 	void set_conf(const atomv& atoms, vecv& coords, const ligand_conf& c) {
 		node.set_conf(atoms, coords, c.rigid);
@@ -217,6 +281,13 @@ struct heterotree {
 		node.set_derivative(force_torque, d);
 		assert(p == c.torsions.end());
 	}
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & node;
+		ar & children;
+	}
 };
 
 template<typename T> // T = main_branch, branch, flexible_body
@@ -247,6 +318,12 @@ struct vector_mutable : public std::vector<T> {
 		VINA_FOR_IN(i, (*this))
 			(*this)[i].derivative(coords, forces, c[i]);
 	}
+private:
+	friend class boost::serialization::access;
+	template<class Archive> 
+	void serialize(Archive& ar, const unsigned version) {
+		ar & boost::serialization::base_object< std::vector<T> >(*this);
+	}
 };
 
 template<typename T, typename F> // tree or heterotree - like structure
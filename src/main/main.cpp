@@ -24,27 +24,30 @@
 #include <string>
 #include <exception>
 #include <vector> // ligand paths
-#include <cmath> // for ceila
 #include <iomanip> // for setprecision, fixed
+#include <sstream>
 #include <boost/program_options.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/exception.hpp>
 #include <boost/filesystem/convenience.hpp> // filesystem::basename
 #include <boost/thread/thread.hpp> // hardware_concurrency // FIXME rm ?
 #include <boost/timer.hpp>
+#include <boost/scoped_ptr.hpp>
 #include "parse_pdbqt.h"
-#include "parallel_mc.h"
+#include "ligand_library.h"
+#include "receptor_snapshot.h"
+#include "compressed_file.h"
 #include "file.h"
-#include "cache.h"
-#include "non_cache.h"
-#include "naive_non_cache.h"
 #include "parse_error.h"
 #include "everything.h"
 #include "weighted_terms.h"
 #include "current_weights.h"
-#include "quasi_newton.h"
 #include "tee.h"
-#include "coords.h" // add_to_output_container
+#include "job_report.h"
+#include "trace.h"
+#include "huge_pages.h"
+#include "docking.h"
+#include "server.h"
 
 using boost::filesystem::path;
 
@@ -52,368 +55,17 @@ path make_path(const std::string& str) {
 	return path(str);
 }
 
-void doing(int verbosity, const std::string& str, tee& log) {
-	if(verbosity > 1) {
-		log << str << std::string(" ... ");
-		log.flush();
-	}
-}
-
-void done(int verbosity, tee& log) {
-	if(verbosity > 1) {
-		log << "done.";
-		log.endl();
-	}
-}
-
-void done_with_time(int verbosity, tee& log, double elapsed_time) {
-	if(verbosity > 1) {
-		log << "done (elapsed time: " << std::fixed << std::setprecision(3) << elapsed_time << "s).";
-		log.endl();
-	}
-}
 std::string default_output(const std::string& input_name) {
 	std::string tmp = input_name;
+	std::string compressed; // compressed input, compressed output
+	const std::string extension = make_path(tmp).extension().string();
+	if(extension == ".gz" || extension == ".zst") {
+		compressed = extension;
+		tmp.resize(tmp.size() - extension.size());
+	}
 	if(tmp.size() >= 6 && tmp.substr(tmp.size()-6, 6) == ".pdbqt")
 		tmp.resize(tmp.size() - 6); // FIXME?
-	return tmp + "_out.pdbqt";
-}
-
-void write_all_output(model& m, const output_container& out, sz how_many,
-				  const std::string& output_name,
-				  const std::vector<std::string>& remarks) {
-	if(out.size() < how_many)
-		how_many = out.size();
-	VINA_CHECK(how_many <= remarks.size());
-	ofile f(make_path(output_name));
-	VINA_FOR(i, how_many) {
-		m.set(out[i].c);
-		m.write_model(f, i+1, remarks[i]); // so that model numbers start with 1
-	}
-}
-
-void do_randomization(model& m,
-					  const std::string& out_name,
-					  const vec& corner1, const vec& corner2, int seed, int verbosity, tee& log) {
-	conf init_conf = m.get_initial_conf();
-	rng generator(static_cast<rng::result_type>(seed));
-	if(verbosity > 1) {
-		log << "Using random seed: " << seed;
-		log.endl();
-		log << "Attempting to find low-clash initial conformation...";
-		log.endl();
-	}
-	const sz attempts = 10000;
-	conf best_conf = init_conf;
-	fl best_clash_penalty = 0;
-	VINA_FOR(i, attempts) {
-		conf c = init_conf;
-		c.randomize(corner1, corner2, generator);
-		m.set(c);
-		fl penalty = m.clash_penalty();
-		if(i == 0 || penalty < best_clash_penalty) {
-			best_conf = c;
-			best_clash_penalty = penalty;
-			if(verbosity > 2 && (i < 10 || (i+1) % 1000 == 0)) {
-				log << "  Attempt " << (i+1) << "/" << attempts << ": new best clash penalty = " << penalty;
-				log.endl();
-			}
-		}
-	}
-	m.set(best_conf);
-	if(verbosity > 1) {
-		log << "Best clash penalty found: " << best_clash_penalty;
-		log.endl();
-	}
-	m.write_structure(make_path(out_name));
-}
-
-void refine_structure(model& m, const precalculate& prec, non_cache& nc, output_type& out, const vec& cap, sz max_steps = 1000) {
-	change g(m.get_size());
-	quasi_newton quasi_newton_par;
-	quasi_newton_par.max_steps = max_steps;
-	const fl slope_orig = nc.slope;
-	VINA_FOR(p, 5) {
-		nc.slope = 100 * std::pow(10.0, 2.0*p);
-		quasi_newton_par(m, prec, nc, out, g, cap);
-		m.set(out.c); // just to be sure
-		if(nc.within(m))
-			break;
-	}
-	out.coords = m.get_heavy_atom_movable_coords();
-	if(!nc.within(m))
-		out.e = max_fl;
-	nc.slope = slope_orig;
-}
-
-std::string vina_remark(fl e, fl lb, fl ub) {
-	std::ostringstream remark;
-	remark.setf(std::ios::fixed, std::ios::floatfield);
-	remark.setf(std::ios::showpoint);
-	remark << "REMARK VINA RESULT: " 
-		                << std::setw(9) << std::setprecision(1) << e
-	                    << "  " << std::setw(9) << std::setprecision(3) << lb
-						<< "  " << std::setw(9) << std::setprecision(3) << ub
-						<< '\n';
-	return remark.str();
-}
-
-output_container remove_redundant(const output_container& in, fl min_rmsd) {
-	output_container tmp;
-	VINA_FOR_IN(i, in)
-		add_to_output_container(tmp, in[i], min_rmsd, in.size());
-	return tmp;
-}
-
-void do_search(model& m, const boost::optional<model>& ref, const scoring_function& sf, const precalculate& prec, const igrid& ig, const precalculate& prec_widened, const igrid& ig_widened, non_cache& nc, // nc.slope is changed
-			   const std::string& out_name,
-			   const vec& corner1, const vec& corner2,
-			   const parallel_mc& par, fl energy_range, sz num_modes,
-			   int seed, int verbosity, bool score_only, bool local_only, tee& log, const terms& t, const flv& weights) {
-	conf_size s = m.get_size();
-	conf c = m.get_initial_conf();
-	fl e = max_fl;
-	const vec authentic_v(1000, 1000, 1000);
-	if(score_only) {
-		fl intramolecular_energy = m.eval_intramolecular(prec, authentic_v, c);
-		naive_non_cache nnc(&prec); // for out of grid issues
-		e = m.eval_adjusted(sf, prec, nnc, authentic_v, c, intramolecular_energy);
-		log << "Affinity: " << std::fixed << std::setprecision(5) << e << " (kcal/mol)";
-		log.endl();
-		flv term_values = t.evale_robust(m);
-		VINA_CHECK(term_values.size() == 5);
-		log << "Intermolecular contributions to the terms, before weighting:\n";
-		log << std::setprecision(5);
-		log << "    gauss 1     : " << term_values[0] << '\n';
-		log << "    gauss 2     : " << term_values[1] << '\n';
-		log << "    repulsion   : " << term_values[2] << '\n';
-		log << "    hydrophobic : " << term_values[3] << '\n';
-		log << "    Hydrogen    : " << term_values[4] << '\n';
-		VINA_CHECK(weights.size() == term_values.size() + 1);
-		fl e2 = 0;
-		VINA_FOR_IN(i, term_values)
-			e2 += term_values[i] * weights[i];
-		e2 = sf.conf_independent(m, e2);
-		if(e < 100 && std::abs(e2 - e) > 0.05) {
-			log << "WARNING: the individual terms are inconsisent with the\n";
-			log << "WARNING: affinity. Consider reporting this as a bug:\n";
-			log << "WARNING: http://vina.scripps.edu/manual.html#bugs\n";
-		}
-	}
-	else if(local_only) {
-		output_type out(c, e);
-		doing(verbosity, "Performing local search", log);
-		refine_structure(m, prec, nc, out, authentic_v, par.mc.ssd_par.evals);
-		done(verbosity, log);
-		fl intramolecular_energy = m.eval_intramolecular(prec, authentic_v, out.c);
-		e = m.eval_adjusted(sf, prec, nc, authentic_v, out.c, intramolecular_energy);
-
-		log << "Affinity: " << std::fixed << std::setprecision(5) << e << " (kcal/mol)";
-		log.endl();
-		if(!nc.within(m))
-			log << "WARNING: not all movable atoms are within the search space\n";
-
-		doing(verbosity, "Writing output", log);
-		output_container out_cont;
-		out_cont.push_back(new output_type(out));
-		std::vector<std::string> remarks(1, vina_remark(e, 0, 0));
-		write_all_output(m, out_cont, 1, out_name, remarks); // how_many == 1
-		done(verbosity, log);
-	}
-	else {
-		rng generator(static_cast<rng::result_type>(seed));
-		log << "Using random seed: " << seed;
-		log.endl();
-		output_container out_cont;
-		
-		if(verbosity > 1) {
-			log << "Search parameters:";
-			log.endl();
-			log << "  Number of runs: " << par.num_tasks;
-			log.endl();
-			log << "  Steps per run: " << par.mc.num_steps;
-			log.endl();
-			log << "  Number of threads: " << par.num_threads;
-			log.endl();
-		}
-		
-		boost::timer search_timer;
-		doing(verbosity, "Performing search", log);
-		par(m, out_cont, prec, ig, prec_widened, ig_widened, corner1, corner2, generator);
-		done_with_time(verbosity, log, search_timer.elapsed());
-		
-		if(verbosity > 1) {
-			log << "Search produced " << out_cont.size() << " initial results";
-			log.endl();
-			if(!out_cont.empty()) {
-				log << "Best energy found: " << std::fixed << std::setprecision(3) << out_cont.front().e << " (kcal/mol)";
-				log.endl();
-			}
-		}
-
-		boost::timer refine_timer;
-		doing(verbosity, "Refining results", log);
-		VINA_FOR_IN(i, out_cont)
-			refine_structure(m, prec, nc, out_cont[i], authentic_v, par.mc.ssd_par.evals);
-
-		if(!out_cont.empty()) {
-			out_cont.sort();
-			const fl best_mode_intramolecular_energy = m.eval_intramolecular(prec, authentic_v, out_cont[0].c);
-			VINA_FOR_IN(i, out_cont)
-				if(not_max(out_cont[i].e))
-					out_cont[i].e = m.eval_adjusted(sf, prec, nc, authentic_v, out_cont[i].c, best_mode_intramolecular_energy); 
-			// the order must not change because of non-decreasing g (see paper), but we'll re-sort in case g is non strictly increasing
-			out_cont.sort();
-		}
-
-		const fl out_min_rmsd = 1;
-		out_cont = remove_redundant(out_cont, out_min_rmsd);
-
-		done_with_time(verbosity, log, refine_timer.elapsed());
-		
-		if(verbosity > 1 && !out_cont.empty()) {
-			log << "After refinement, " << out_cont.size() << " unique conformations";
-			log.endl();
-		}
-
-		log.setf(std::ios::fixed, std::ios::floatfield);
-		log.setf(std::ios::showpoint);
-		log << '\n';
-		log << "mode |   affinity | dist from best mode\n";
-		log << "     | (kcal/mol) | rmsd l.b.| rmsd u.b.\n";
-		log << "-----+------------+----------+----------\n";
-
-		model best_mode_model = m;
-		if(!out_cont.empty())
-			best_mode_model.set(out_cont.front().c);
-
-		sz how_many = 0;
-		std::vector<std::string> remarks;
-		VINA_FOR_IN(i, out_cont) {
-			if(how_many >= num_modes || !not_max(out_cont[i].e) || out_cont[i].e > out_cont[0].e + energy_range) break; // check energy_range sanity FIXME
-			++how_many;
-			log << std::setw(4) << i+1
-				<< "    " << std::setw(9) << std::setprecision(1) << out_cont[i].e; // intermolecular_energies[i];
-			m.set(out_cont[i].c);
-			const model& r = ref ? ref.get() : best_mode_model;
-			const fl lb = m.rmsd_lower_bound(r);
-			const fl ub = m.rmsd_upper_bound(r);
-			log << "  " << std::setw(9) << std::setprecision(3) << lb
-			    << "  " << std::setw(9) << std::setprecision(3) << ub; // FIXME need user-readable error messages in case of failures
-
-			remarks.push_back(vina_remark(out_cont[i].e, lb, ub));
-			log.endl();
-		}
-		doing(verbosity, "Writing output", log);
-		write_all_output(m, out_cont, how_many, out_name, remarks);
-		done(verbosity, log);
-
-		if(how_many < 1) {
-			log << "WARNING: Could not find any conformations completely within the search space.\n"
-				<< "WARNING: Check that it is large enough for all movable atoms, including those in the flexible side chains.";
-			log.endl();
-		}
-	}
-}
-
-void main_procedure(model& m, const boost::optional<model>& ref, // m is non-const (FIXME?)
-			     const std::string& out_name,
-				 bool score_only, bool local_only, bool randomize_only, bool no_cache,
-				 const grid_dims& gd, int exhaustiveness,
-				 const flv& weights,
-				 int cpu, int seed, int verbosity, sz num_modes, fl energy_range, tee& log) {
-
-	boost::timer timer;
-	doing(verbosity, "Setting up the scoring function", log);
-
-	everything t;
-	VINA_CHECK(weights.size() == 6);
-
-	weighted_terms wt(&t, weights);
-	precalculate prec(wt);
-	const fl left  = 0.25; 
-	const fl right = 0.25;
-	precalculate prec_widened(prec); prec_widened.widen(left, right);
-
-	done_with_time(verbosity, log, timer.elapsed());
-
-	vec corner1(gd[0].begin, gd[1].begin, gd[2].begin);
-	vec corner2(gd[0].end,   gd[1].end,   gd[2].end);
-	
-	if(verbosity > 1 && !score_only) {
-		fl size_x = corner2[0] - corner1[0];
-		fl size_y = corner2[1] - corner1[1];
-		fl size_z = corner2[2] - corner1[2];
-		fl volume = size_x * size_y * size_z;
-		
-		log << "Search space:";
-		log.endl();
-		log << "  Center: (" << std::fixed << std::setprecision(3) 
-		    << (corner1[0] + corner2[0])/2 << ", " 
-		    << (corner1[1] + corner2[1])/2 << ", " 
-		    << (corner1[2] + corner2[2])/2 << ")";
-		log.endl();
-		log << "  Size: (" << std::fixed << std::setprecision(3) 
-		    << size_x << " x " 
-		    << size_y << " x " 
-		    << size_z << ") Angstrom";
-		log.endl();
-		log << "  Volume: " << std::fixed << std::setprecision(1) 
-		    << volume << " Angstrom^3";
-		log.endl();
-	}
-
-	parallel_mc par;
-	sz heuristic = m.num_movable_atoms() + 10 * m.get_size().num_degrees_of_freedom();
-	par.mc.num_steps = unsigned(70 * 3 * (50 + heuristic) / 2); // 2 * 70 -> 8 * 20 // FIXME
-	par.mc.ssd_par.evals = unsigned((25 + m.num_movable_atoms()) / 3);
-	par.mc.min_rmsd = 1.0;
-	par.mc.num_saved_mins = 20;
-	par.mc.hunt_cap = vec(10, 10, 10);
-	par.num_tasks = exhaustiveness;
-	par.num_threads = cpu;
-	par.display_progress = (verbosity > 1);
-	
-	if(verbosity > 1 && !score_only) {
-		log << "Ligand information:";
-		log.endl();
-		log << "  Movable atoms: " << m.num_movable_atoms();
-		log.endl();
-		log << "  Degrees of freedom: " << m.get_size().num_degrees_of_freedom();
-		log.endl();
-		log << "  Computed heuristic: " << heuristic;
-		log.endl();
-	}
-
-	const fl slope = 1e6; // FIXME: too large? used to be 100
-	if(randomize_only) {
-		do_randomization(m, out_name,
-			             corner1, corner2, seed, verbosity, log);
-	}
-	else {
-		non_cache nc        (m, gd, &prec,         slope); // if gd has 0 n's, this will not constrain anything
-		non_cache nc_widened(m, gd, &prec_widened, slope); // if gd has 0 n's, this will not constrain anything
-		if(no_cache) {
-			do_search(m, ref, wt, prec, nc, prec_widened, nc_widened, nc,
-					  out_name,
-					  corner1, corner2,
-					  par, energy_range, num_modes,
-					  seed, verbosity, score_only, local_only, log, t, weights);
-		}
-		else {
-			bool cache_needed = !(score_only || randomize_only || local_only);
-			boost::timer cache_timer;
-			if(cache_needed) doing(verbosity, "Analyzing the binding site", log);
-			cache c("scoring_function_version001", gd, slope, atom_type::XS);
-			if(cache_needed) c.populate(m, prec, m.get_movable_atom_types(prec.atom_typing_used()));
-			if(cache_needed) done_with_time(verbosity, log, cache_timer.elapsed());
-			do_search(m, ref, wt, prec, c, prec, c, nc,
-					  out_name,
-					  corner1, corner2,
-					  par, energy_range, num_modes,
-					  seed, verbosity, score_only, local_only, log, t, weights);
-		}
-	}
+	return tmp + "_out.pdbqt" + compressed;
 }
 
 struct usage_error : public std::runtime_error {
@@ -449,9 +101,21 @@ void check_occurrence(boost::program_options::variables_map& vm, boost::program_
 	}
 }
 
-model parse_bundle(const std::string& rigid_name, const boost::optional<std::string>& flex_name_opt, const std::vector<std::string>& ligand_names) {
-	model tmp = (flex_name_opt) ? parse_receptor_pdbqt(make_path(rigid_name), make_path(flex_name_opt.get()))
-		                        : parse_receptor_pdbqt(make_path(rigid_name));
+model parse_receptor(const std::string& rigid_name, const boost::optional<std::string>& flex_name_opt, receptor_crop* crop, sz num_threads) { // crop is NULL if the whole receptor is needed
+	if(is_receptor_snapshot(make_path(rigid_name))) { // already set up, so there is nothing to gain from cropping it
+		if(flex_name_opt)
+			throw usage_error("A receptor snapshot already includes its flexible side chains, if any, so flex can not be used with it");
+		return read_receptor_snapshot(make_path(rigid_name));
+	}
+	if(crop)
+		return (flex_name_opt) ? parse_receptor_pdbqt(make_path(rigid_name), make_path(flex_name_opt.get()), *crop, num_threads)
+		                       : parse_receptor_pdbqt(make_path(rigid_name), *crop, num_threads);
+	return (flex_name_opt) ? parse_receptor_pdbqt(make_path(rigid_name), make_path(flex_name_opt.get()), num_threads)
+		                   : parse_receptor_pdbqt(make_path(rigid_name), num_threads);
+}
+
+model parse_bundle(const std::string& rigid_name, const boost::optional<std::string>& flex_name_opt, receptor_crop* crop, const std::vector<std::string>& ligand_names, sz num_threads) {
+	model tmp = parse_receptor(rigid_name, flex_name_opt, crop, num_threads);
 	VINA_FOR_IN(i, ligand_names)
 		tmp.append(parse_ligand_pdbqt(make_path(ligand_names[i])));
 	return tmp;
@@ -465,13 +129,131 @@ model parse_bundle(const std::vector<std::string>& ligand_names) {
 	return tmp;
 }
 
-model parse_bundle(const boost::optional<std::string>& rigid_name_opt, const boost::optional<std::string>& flex_name_opt, const std::vector<std::string>& ligand_names) {
+model parse_bundle(const boost::optional<std::string>& rigid_name_opt, const boost::optional<std::string>& flex_name_opt, receptor_crop* crop, const std::vector<std::string>& ligand_names, sz num_threads) {
 	if(rigid_name_opt)
-		return parse_bundle(rigid_name_opt.get(), flex_name_opt, ligand_names);
+		return parse_bundle(rigid_name_opt.get(), flex_name_opt, crop, ligand_names, num_threads);
 	else
 		return parse_bundle(ligand_names);
 }
 
+void log_crop(const receptor_crop* crop, tee& log) {
+	if(crop && crop->parsed > 0) { // not for snapshots
+		log << "  Receptor atoms near the search space: " << crop->kept << " of " << crop->parsed;
+		log.endl();
+	}
+}
+
+void log_receptor(const std::string& rigid_name, const boost::optional<std::string>& flex_name_opt, const receptor_crop* crop, tee& log) {
+	log << "  Receptor: " << rigid_name;
+	log.endl();
+	log_crop(crop, log);
+	if(flex_name_opt) {
+		log << "  Flexible residues: " << flex_name_opt.get();
+		log.endl();
+	}
+}
+
+struct search_options { // what main_procedure is given for each ligand, besides the complex, the setup and the search space
+	bool score_only, local_only, randomize_only, randomize_until_clash_free;
+	int exhaustiveness, cpu, seed, verbosity;
+	sz num_modes;
+	fl energy_range;
+};
+
+// the ligand library and the server dock their ligands one after another, with the receptor and the scoring set up once;
+// this is what they share: that setup, and the same steps around each ligand
+struct ligand_series : private boost::noncopyable {
+	sz count; // of the ligands begun
+
+	ligand_series(const model& receptor_, const phase_time& setup_parse_, const grid_dims& gd_, const flv& weights_, const grid_options& grids, const search_options& search_,
+	              tee& log_, async_writer& writer_, std::ostream* report_stream_, report_format report_fmt_, std::ostream* trace_stream_)
+		: count(0), receptor(receptor_), gd(gd_), weights(weights_), search(search_), log(log_), writer(writer_),
+		  report_stream(report_stream_), report_fmt(report_fmt_), trace_stream(trace_stream_), setup_parse(setup_parse_) {
+		boost::timer timer;
+		traced_phase precalculate_time("precalculate");
+		doing(search.verbosity, "Setting up the scoring function", log);
+		setup.reset(new scoring_setup(weights, gd, grids));
+		setup_precalculate = precalculate_time.end();
+		done_with_time(search.verbosity, log, timer.elapsed());
+	}
+
+	void begin(const std::string& name, sz model = 0, const std::string& tag = std::string()) { // the next ligand, and which one of a library it is; the one-time setup is charged to the first
+		++count;
+		report = job_report();
+		report.ligand = name;
+		report.index = count;
+		report.model = model;
+		report.tag = tag;
+		if(count == 1) {
+			report.parse = setup_parse;
+			report.precalculate = setup_precalculate;
+		}
+		span.reset(new trace_span("ligand", "ligand", count));
+	}
+
+	template<typename Ligand> // ligand() parses it, and can throw parse_error and the like
+	void dock(const Ligand& ligand, std::ostream* out) {
+		traced_phase parse_time("parse");
+		model m = receptor;
+		m.append(ligand());
+		report.parse += parse_time.end();
+		main_procedure(m, boost::optional<model>(), *setup,
+					out,
+					search.score_only, search.local_only, search.randomize_only, search.randomize_until_clash_free, false, // no_cache == false
+					gd, search.exhaustiveness,
+					weights,
+					search.cpu, search.seed, search.verbosity, search.num_modes, search.energy_range, log, report);
+		report.docked = true;
+	}
+
+	const job_report& current() const { return report; }
+
+	void end(std::ostream* out) { // whether the ligand was docked or not; out, if not NULL, is flushed as one job of the writer
+		if(report_stream)
+			write_report(*report_stream, report_fmt, report);
+		span.reset(); // ends it
+		if(trace_stream)
+			write_trace(*trace_stream);
+		if(out)
+			out->flush();
+		writer.end_job();
+	}
+
+	void finish() { // after the last ligand
+		if(trace_stream)
+			end_trace(*trace_stream);
+	}
+private:
+	const model& receptor;
+	const grid_dims& gd;
+	const flv& weights;
+	search_options search;
+	tee& log;
+	async_writer& writer;
+	std::ostream* report_stream;
+	report_format report_fmt;
+	std::ostream* trace_stream;
+	phase_time setup_parse, setup_precalculate;
+	boost::scoped_ptr<scoring_setup> setup;
+	job_report report;
+	boost::scoped_ptr<trace_span> span;
+};
+
+struct library_ligand { // the current one of the library
+	const ligand_library& ligands;
+	library_ligand(const ligand_library& ligands_) : ligands(ligands_) {}
+	model operator()() const { return ligands.parse(); }
+};
+
+struct server_ligand {
+	const server_job& job;
+	server_ligand(const server_job& job_) : job(job_) {}
+	model operator()() const {
+		return job.file.empty() ? parse_ligand_pdbqt(make_path(job.id), job.pdbqt.data(), job.pdbqt.data() + job.pdbqt.size())
+		                        : parse_ligand_pdbqt(job.file);
+	}
+};
+
 int main(int argc, char* argv[]) {
 	using namespace boost::program_options;
 	const std::string version_string = "AutoDock Vina 1.1.2 (May 11, 2011)";
@@ -510,10 +292,12 @@ Thank you!\n";
 #################################################################\n";
 
 	try {
-		std::string rigid_name, ligand_name, flex_name, config_name, out_name, log_name;
+		std::string rigid_name, ligand_name, library_name, flex_name, config_name, out_name, log_name, report_name, trace_name, flush_name = "line", grid_storage_name = "double", numa_grids_name = "first_touch", huge_pages_name = "transparent";
 		fl center_x, center_y, center_z, size_x, size_y, size_z;
 		int cpu = 0, seed, exhaustiveness, verbosity = 2, num_modes = 9;
+		sz library_slice = 1, library_slices = 1;
 		fl energy_range = 2.0;
+		fl coarse_grid = 0;
 
 		// -0.035579, -0.005156, 0.840245, -0.035069, -0.587439, 0.05846
 		fl weight_gauss1      = -0.035579;
@@ -522,15 +306,17 @@ Thank you!\n";
 		fl weight_hydrophobic = -0.035069;
 		fl weight_hydrogen    = -0.587439;
 		fl weight_rot         =  0.05846;
-		bool score_only = false, local_only = false, randomize_only = false, help = false, help_advanced = false, version = false; // FIXME
+		bool score_only = false, local_only = false, randomize_only = false, randomize_until_clash_free = false, server = false, instrument = false, cpu_affinity = false, sparse_grids = false, help = false, help_advanced = false, version = false; // FIXME
 
 		positional_options_description positional; // remains empty
 
 		options_description inputs("Input");
 		inputs.add_options()
-			("receptor", value<std::string>(&rigid_name), "rigid part of the receptor (PDBQT)")
+			("receptor", value<std::string>(&rigid_name), "rigid part of the receptor (PDBQT, or a vina_prepare snapshot)")
 			("flex", value<std::string>(&flex_name), "flexible side chains, if any (PDBQT)")
-			("ligand", value<std::string>(&ligand_name), "ligand (PDBQT)")
+			("ligand", value<std::string>(&ligand_name), "ligand (PDBQT, which may be gzip-compressed, like the other inputs)")
+			("ligand_library", value<std::string>(&library_name), "instead of --ligand, many ligands as MODELs of one PDBQT file (or a vina_prepare archive), docked one after another")
+			("server", bool_switch(&server), "instead of --ligand, dock the ligands that come on stdin and answer with the modes and their scores on stdout, setting up the receptor only once (the protocol is in server.h)")
 		;
 		//options_description search_area("Search area (required, except with --score_only)");
 		options_description search_area("Search space (required)");
@@ -545,14 +331,27 @@ Thank you!\n";
 		//options_description outputs("Output prefixes (optional - by default, input names are stripped of .pdbqt\nare used as prefixes. _001.pdbqt, _002.pdbqt, etc. are appended to the prefixes to produce the output names");
 		options_description outputs("Output (optional)");
 		outputs.add_options()
-			("out", value<std::string>(&out_name), "output models (PDBQT), the default is chosen based on the ligand file name")
+			("out", value<std::string>(&out_name), "output models (PDBQT, gzip-compressed if the name ends in .gz), the default is chosen based on the ligand file name")
 			("log", value<std::string>(&log_name), "optionally, write log file")
+			("report", value<std::string>(&report_name), "optionally, write the time taken by each phase and the search counters, one record per ligand (JSON Lines, or CSV if the name ends in .csv)")
+			("trace", value<std::string>(&trace_name), "optionally, write a timeline of the phases and threads in the Chrome trace event format (for chrome://tracing or ui.perfetto.dev)")
 		;
 		options_description advanced("Advanced options (see the manual)");
 		advanced.add_options()
 			("score_only",     bool_switch(&score_only),     "score only - search space can be omitted")
 			("local_only",     bool_switch(&local_only),     "do local search only")
 			("randomize_only", bool_switch(&randomize_only), "randomize input, attempting to avoid clashes")
+			("randomize_until_clash_free", bool_switch(&randomize_until_clash_free), "with randomize_only, stop as soon as a clash-free conformation is found")
+			("library_slice", value<sz>(&library_slice)->default_value(library_slice), "with ligand_library, dock only this slice of the file (1 to library_slices)")
+			("library_slices", value<sz>(&library_slices)->default_value(library_slices), "with ligand_library, the number of roughly equal parts the file is split into, one per worker")
+			("instrument", bool_switch(&instrument), "count and time the calls of the inner loops, for the report (needs a build with VINA_INSTRUMENT defined)")
+			("flush", value<std::string>(&flush_name)->default_value(flush_name), "when the screen, log and output are flushed: line (after every line), ligand (after every ligand of a library) or exit (only at the end)")
+			("huge_pages", value<std::string>(&huge_pages_name)->default_value(huge_pages_name), "how the grids and the precalculated tables are allocated: transparent (in transparent huge pages, if the system allows), reserved (in the huge pages set aside in /proc/sys/vm/nr_hugepages) or off; ordinary pages are used when these can not be had")
+			("cpu_affinity", bool_switch(&cpu_affinity), "pin the search threads to CPUs, spread evenly over the NUMA nodes (needs a build with VINA_NUMA defined)")
+			("numa_grids", value<std::string>(&numa_grids_name)->default_value(numa_grids_name), "where the grids are on machines with several NUMA nodes: first_touch (on the node that computed them), replicate (copied onto every node) or interleave (spread over the nodes); the last two need a build with VINA_NUMA defined")
+			("coarse_grid", value<fl>(&coarse_grid)->default_value(coarse_grid), "if not 0, the spacing (Angstrom) of coarser maps, such as 0.75, used for the first local optimization in each Monte Carlo step; the later optimizations keep the 0.375 maps")
+			("grid_storage", value<std::string>(&grid_storage_name)->default_value(grid_storage_name), "how the maps are stored: double, float (in half the memory) or int16 (in a quarter, scaled to the range of each map, with the energies of the worst clashes capped)")
+			("sparse_grids", bool_switch(&sparse_grids), "compute the maps in bricks of 3 A as the search first reaches them, rather than all at once: for boxes much larger than the ligand (blind docking)")
 			("weight_gauss1", value<fl>(&weight_gauss1)->default_value(weight_gauss1),                "gauss_1 weight")
 			("weight_gauss2", value<fl>(&weight_gauss2)->default_value(weight_gauss2),                "gauss_2 weight")
 			("weight_repulsion", value<fl>(&weight_repulsion)->default_value(weight_repulsion),       "repulsion weight")
@@ -624,7 +423,7 @@ Thank you!\n";
 		}
 
 		bool search_box_needed = !score_only; // randomize_only and local_only still need the search space
-		bool output_produced   = !score_only; 
+		bool output_produced   = !score_only && !server; // the server answers on stdout
 		bool receptor_needed   = !randomize_only;
 
 		if(receptor_needed) {
@@ -633,10 +432,29 @@ Thank you!\n";
 				return 1;
 			}
 		}
-		if(vm.count("ligand") <= 0) {
+		const bool library = vm.count("ligand_library") > 0;
+		if(vm.count("ligand") <= 0 && !library && !server) {
 			std::cerr << "Missing ligand.\n" << "\nCorrect usage:\n" << desc_simple << '\n';
 			return 1;
 		}
+		if(library) {
+			if(vm.count("ligand") > 0)
+				throw usage_error("Use either ligand or ligand_library, not both");
+			if(randomize_only)
+				throw usage_error("randomize_only does not work with ligand_library");
+			if(library_slices < 1 || library_slice < 1 || library_slice > library_slices)
+				throw usage_error("library_slice must be between 1 and library_slices");
+		}
+		if(server) {
+			if(vm.count("ligand") > 0 || library)
+				throw usage_error("The server gets its ligands on stdin, so ligand and ligand_library can not be used with it");
+			if(vm.count("out") > 0)
+				throw usage_error("The server answers on stdout, so out can not be used with it");
+			if(randomize_only)
+				throw usage_error("randomize_only does not work with server");
+			if(score_only)
+				throw usage_error("score_only does not work with server, as its answers carry the modes");
+		}
 		if(cpu < 1) 
 			cpu = 1;
 		if(vm.count("seed") == 0) 
@@ -658,9 +476,74 @@ Thank you!\n";
 		if(vm.count("flex") && !vm.count("receptor"))
 			throw usage_error("Flexible side chains are not allowed without the rest of the receptor"); // that's the only way parsing works, actually
 
+		flush_policy flush;
+		if     (flush_name == "line")   flush = FLUSH_LINE;
+		else if(flush_name == "ligand") flush = FLUSH_JOB;
+		else if(flush_name == "exit")   flush = FLUSH_EXIT;
+		else throw usage_error("flush must be line, ligand or exit");
+
+		if     (huge_pages_name == "transparent") set_huge_pages(HUGE_PAGES_TRANSPARENT);
+		else if(huge_pages_name == "reserved")    set_huge_pages(HUGE_PAGES_RESERVED);
+		else if(huge_pages_name == "off")         set_huge_pages(HUGE_PAGES_OFF);
+		else throw usage_error("huge_pages must be transparent, reserved or off");
+
+		grid_options grids; // for every scoring_setup below
+		if(coarse_grid != 0 && coarse_grid <= 0.375)
+			throw usage_error("coarse_grid must be 0 or greater than the spacing of the maps, 0.375");
+		if(coarse_grid != 0 && sparse_grids)
+			throw usage_error("coarse_grid and sparse_grids can not be combined");
+		grids.coarse = coarse_grid;
+		grids.sparse = sparse_grids;
+
+		if     (grid_storage_name == "double") grids.storage = GRID_DOUBLE;
+		else if(grid_storage_name == "float")  grids.storage = GRID_FLOAT;
+		else if(grid_storage_name == "int16")  grids.storage = GRID_QUANTIZED;
+		else throw usage_error("grid_storage must be double, float or int16");
+		if(grids.storage != GRID_DOUBLE && sparse_grids)
+			throw usage_error("grid_storage and sparse_grids can not be combined");
+
+		grids.numa.pin_threads = cpu_affinity;
+		if     (numa_grids_name == "first_touch") grids.numa.grids = NUMA_FIRST_TOUCH;
+		else if(numa_grids_name == "replicate")   grids.numa.grids = NUMA_REPLICATE;
+		else if(numa_grids_name == "interleave")  grids.numa.grids = NUMA_INTERLEAVE;
+		else throw usage_error("numa_grids must be first_touch, replicate or interleave");
+		if(grids.numa.grids != NUMA_FIRST_TOUCH && sparse_grids)
+			throw usage_error("numa_grids and sparse_grids can not be combined");
+		if(!numa_compiled && (grids.numa.pin_threads || grids.numa.grids != NUMA_FIRST_TOUCH))
+			throw usage_error("cpu_affinity and numa_grids need a build with VINA_NUMA defined (see makefile_common)");
+
+		if(instrument) {
+			if(!instrumentation_compiled)
+				throw usage_error("instrument needs a build with VINA_INSTRUMENT defined (see makefile_common)");
+			set_instrumentation(true);
+		}
+		if(vm.count("trace") > 0)
+			start_tracing(); // this thread is the first one on the timeline
+
+		async_writer writer(flush); // the search threads never wait for the screen or the disk
 		tee log;
+		if(server)
+			log.console = &std::cerr; // stdout is for the answers
 		if(vm.count("log") > 0)
 			log.init(log_name);
+		log.init(writer);
+
+		boost::scoped_ptr<ofile> report_file;
+		boost::scoped_ptr<async_ostream> report_stream; // destroyed first, waiting for the writer
+		report_format report_fmt = REPORT_JSON;
+		if(vm.count("report") > 0) {
+			const path report_path = make_path(report_name);
+			report_fmt = report_format_from_name(report_path);
+			report_file.reset(new ofile(report_path));
+			report_stream.reset(new async_ostream(writer, *report_file));
+			write_report_header(*report_stream, report_fmt);
+		}
+		boost::scoped_ptr<ofile> trace_file;
+		boost::scoped_ptr<async_ostream> trace_stream; // destroyed first, waiting for the writer
+		if(vm.count("trace") > 0) {
+			trace_file.reset(new ofile(make_path(trace_name)));
+			trace_stream.reset(new async_ostream(writer, *trace_file));
+		}
 
 		if(search_box_needed) { 
 			options_occurrence oo = get_occurrence(vm, search_area);
@@ -681,7 +564,7 @@ Thank you!\n";
 
 		if(output_produced) { // FIXME
 			if(!vm.count("out")) {
-				out_name = default_output(ligand_name);
+				out_name = default_output(library ? library_name : ligand_name);
 				log << "Output will be " << out_name << '\n';
 			}
 		}
@@ -696,17 +579,8 @@ Thank you!\n";
 		weights.push_back(weight_hydrogen);
 		weights.push_back(5 * weight_rot / 0.1 - 1); // linearly maps onto a different range, internally. see everything.cpp
 
-		if(search_box_needed) { 
-			const fl granularity = 0.375;
-			vec span(size_x,   size_y,   size_z);
-			vec center(center_x, center_y, center_z);
-			VINA_FOR_IN(i, gd) {
-				gd[i].n = sz(std::ceil(span[i] / granularity));
-				fl real_span = granularity * gd[i].n;
-				gd[i].begin = center[i] - real_span/2;
-				gd[i].end = gd[i].begin + real_span;
-			}
-		}
+		if(search_box_needed)
+			gd = search_space(vec(center_x, center_y, center_z), vec(size_x, size_y, size_z));
 		if(vm.count("cpu") == 0) {
 			unsigned num_cpus = boost::thread::hardware_concurrency();
 			if(verbosity > 1) {
@@ -725,9 +599,135 @@ Thank you!\n";
 		if(verbosity > 1 && exhaustiveness < cpu)
 			log << "WARNING: at low exhaustiveness, it may be impossible to utilize all CPUs\n";
 
+		// only the receptor atoms within the cutoff of the search space are needed, except with score_only, which does not confine the ligand
+		boost::scoped_ptr<receptor_crop> crop;
+		if(search_box_needed) {
+			everything t;
+			crop.reset(new receptor_crop(vec(gd[0].begin, gd[1].begin, gd[2].begin), vec(gd[0].end, gd[1].end, gd[2].end), weighted_terms(&t, weights).cutoff()));
+		}
+
 		doing(verbosity, "Reading input", log);
+		traced_phase parse_time("parse");
+
+		const search_options search = { score_only, local_only, randomize_only, randomize_until_clash_free, exhaustiveness, cpu, seed, verbosity, max_modes_sz, energy_range };
+
+		if(server) {
+			const model receptor = parse_bundle(rigid_name_opt, flex_name_opt, crop.get(), std::vector<std::string>(), cpu);
+			const phase_time setup_parse = parse_time.end(); // the one-time setup is charged to the first ligand
+			done(verbosity, log);
+			if(verbosity > 1) {
+				log << "Input information:";
+				log.endl();
+				log_receptor(rigid_name, flex_name_opt, crop.get(), log);
+			}
+
+			ligand_series series(receptor, setup_parse, gd, weights, grids, search, log, writer, report_stream.get(), report_fmt, trace_stream.get());
+			log << "\nWaiting for ligands on stdin";
+			log.endl();
 
-		model m       = parse_bundle(rigid_name_opt, flex_name_opt, std::vector<std::string>(1, ligand_name));
+			server_job job;
+			sz count = 0;
+			while(read_server_job(std::cin, job)) {
+				++count;
+				if(!job.error.empty()) {
+					write_server_error(std::cout, job.id, job.error);
+					continue;
+				}
+				log << "\nLigand " << job.id;
+				log.endl();
+				series.begin(job.id);
+				std::ostringstream poses;
+				try {
+					series.dock(server_ligand(job), &poses);
+					write_server_result(std::cout, job.id, series.current().mode_energies, poses.str());
+				}
+				catch(file_error& e) { // the server carries on with the next ligand
+					write_server_error(std::cout, job.id, "could not open \"" + e.name.string() + "\" for reading");
+				}
+				catch(parse_error& e) {
+					write_server_error(std::cout, job.id, "parse error on line " + to_string(e.line) + ": " + e.reason);
+				}
+				catch(compression_error& e) {
+					write_server_error(std::cout, job.id, "error reading \"" + e.name.string() + "\": " + e.reason);
+				}
+				catch(archive_error& e) {
+					write_server_error(std::cout, job.id, "error reading \"" + e.name.string() + "\": " + e.reason);
+				}
+				catch(boost::filesystem::filesystem_error& e) {
+					write_server_error(std::cout, job.id, std::string("file system error: ") + e.what());
+				}
+				catch(std::exception& e) { // anything else that went wrong with this job, such as running out of memory
+					write_server_error(std::cout, job.id, e.what());
+				}
+				catch(internal_error& e) {
+					write_server_error(std::cout, job.id, "internal error in " + e.file + "(" + to_string(e.line) + ")");
+				}
+				series.end(NULL); // the answer is already out
+			}
+			log << "\nAnswered " << count << " jobs";
+			log.endl();
+			series.finish();
+			return 0;
+		}
+
+		if(library) {
+			const model receptor = parse_bundle(rigid_name_opt, flex_name_opt, crop.get(), std::vector<std::string>(), cpu);
+			ligand_library ligands(make_path(library_name), library_slice - 1, library_slices);
+			const boost::optional<sz> num_ligands = ligands.size();
+			const phase_time setup_parse = parse_time.end(); // the one-time setup is charged to the first ligand
+			done(verbosity, log);
+
+			if(verbosity > 1) {
+				log << "Input information:";
+				log.endl();
+				log_receptor(rigid_name, flex_name_opt, crop.get(), log);
+				log << "  Ligand library: " << library_name;
+				if(num_ligands)
+					log << ", " << num_ligands.get() << " ligands";
+				if(library_slices > 1)
+					log << " in slice " << library_slice << " of " << library_slices;
+				log.endl();
+			}
+
+			ligand_series series(receptor, setup_parse, gd, weights, grids, search, log, writer, report_stream.get(), report_fmt, trace_stream.get());
+
+			boost::scoped_ptr<ozfile> out_file;
+			boost::scoped_ptr<async_ostream> out_stream; // destroyed first, waiting for the writer
+			if(output_produced) {
+				out_file.reset(new ozfile(make_path(out_name)));
+				out_stream.reset(new async_ostream(writer, *out_file));
+			}
+
+			sz skipped = 0;
+			while(ligands.next()) {
+				series.begin(library_name, ligands.model_number(), ligands.model_tag());
+				log << "\nLigand " << series.count;
+				if(num_ligands)
+					log << " of " << num_ligands.get();
+				log.endl();
+				try {
+					series.dock(library_ligand(ligands), out_stream.get());
+				}
+				catch(parse_error& e) { // one bad molecule should not stop the rest of the library
+					log << "WARNING: skipping this ligand. Parse error on line " << e.line << ": " << e.reason;
+					log.endl();
+					++skipped;
+				}
+				series.end(out_stream.get());
+			}
+			out_stream.reset(); // waits for the writer
+			if(out_file)
+				out_file->close();
+			log << "\nDocked " << (series.count - skipped) << " of " << series.count << " ligands";
+			log.endl();
+			series.finish();
+			return 0;
+		}
+
+		model m       = parse_bundle(rigid_name_opt, flex_name_opt, crop.get(), std::vector<std::string>(1, ligand_name), cpu);
+		job_report report;
+		report.ligand = ligand_name;
+		report.parse = parse_time.end();
 			
 		boost::optional<model> ref;
 		done(verbosity, log);
@@ -735,24 +735,40 @@ Thank you!\n";
 		if(verbosity > 1) {
 			log << "Input information:";
 			log.endl();
-			if(rigid_name_opt) {
-				log << "  Receptor: " << rigid_name;
-				log.endl();
-			}
-			if(flex_name_opt) {
-				log << "  Flexible residues: " << flex_name;
-				log.endl();
-			}
+			if(rigid_name_opt)
+				log_receptor(rigid_name, flex_name_opt, crop.get(), log);
 			log << "  Ligand: " << ligand_name;
 			log.endl();
 		}
 
-		main_procedure(m, ref, 
-					out_name,
-					score_only, local_only, randomize_only, false, // no_cache == false
+		boost::timer timer;
+		traced_phase precalculate_time("precalculate");
+		doing(verbosity, "Setting up the scoring function", log);
+		scoring_setup setup(weights, gd, grids);
+		report.precalculate = precalculate_time.end();
+		done_with_time(verbosity, log, timer.elapsed());
+
+		boost::scoped_ptr<ozfile> out_file;
+		boost::scoped_ptr<async_ostream> out_stream; // destroyed first, waiting for the writer
+		if(output_produced) {
+			out_file.reset(new ozfile(make_path(out_name)));
+			out_stream.reset(new async_ostream(writer, *out_file));
+		}
+
+		main_procedure(m, ref, setup,
+					out_stream.get(),
+					score_only, local_only, randomize_only, randomize_until_clash_free, false, // no_cache == false
 					gd, exhaustiveness,
 					weights,
-					cpu, seed, verbosity, max_modes_sz, energy_range, log);
+					cpu, seed, verbosity, max_modes_sz, energy_range, log, report);
+		report.docked = true;
+		out_stream.reset(); // waits for the writer
+		if(out_file)
+			out_file->close();
+		if(report_stream)
+			write_report(*report_stream, report_fmt, report);
+		if(trace_stream)
+			end_trace(*trace_stream);
 	}
 	catch(file_error& e) {
 		std::cerr << "\n\nError: could not open \"" << e.name.filename() << "\" for " << (e.in ? "reading" : "writing") << ".\n";
@@ -770,6 +786,14 @@ Thank you!\n";
 		std::cerr << "\n\nParse error on line " << e.line << " in file \"" << e.file.filename() << "\": " << e.reason << '\n';
 		return 1;
 	}
+	catch(compression_error& e) {
+		std::cerr << "\n\nError reading or writing \"" << e.name.filename() << "\": " << e.reason << ".\n";
+		return 1;
+	}
+	catch(archive_error& e) {
+		std::cerr << "\n\nError reading \"" << e.name.filename() << "\": " << e.reason << ".\n";
+		return 1;
+	}
 	catch(std::bad_alloc&) {
 		std::cerr << "\n\nError: insufficient memory!\n";
 		return 1;
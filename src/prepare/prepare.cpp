@@ -0,0 +1,205 @@
+/*
+
+   Copyright (c) 2006-2010, The Scripps Research Institute
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   Author: Dr. Oleg Trott <ot14@columbia.edu>, 
+           The Olson Lab, 
+           The Scripps Research Institute
+
+*/
+
+#include <iostream>
+#include <string>
+#include <exception>
+#include <boost/program_options.hpp>
+#include <boost/filesystem/exception.hpp>
+#include <boost/thread/thread.hpp> // hardware_concurrency
+
+#include "ligand_library.h"
+#include "ligand_archive.h"
+#include "receptor_snapshot.h"
+#include "parse_error.h"
+
+path make_path(const std::string& str) {
+	return path(str);
+}
+
+std::string default_output(const std::string& input_name, const std::string& extension_added) {
+	std::string tmp = input_name;
+	const std::string extension = make_path(tmp).extension().string();
+	if(extension == ".gz" || extension == ".zst")
+		tmp.resize(tmp.size() - extension.size());
+	if(tmp.size() >= 6 && tmp.substr(tmp.size()-6, 6) == ".pdbqt")
+		tmp.resize(tmp.size() - 6); // FIXME?
+	return tmp + extension_added;
+}
+
+struct usage_error : public std::runtime_error {
+	usage_error(const std::string& message) : std::runtime_error(message) {}
+};
+
+int main(int argc, char* argv[]) {
+	using namespace boost::program_options;
+	const std::string version_string = "AutoDock Vina Ligand Library Preparation 1.1.2 (May 11, 2011)";
+
+	const std::string error_message = "\n\n\
+Please contact the author, Dr. Oleg Trott <ot14@columbia.edu>, so\n\
+that this problem can be resolved. The reproducibility of the\n\
+error may be vital, so please remember to include the following in\n\
+your problem report:\n\
+* the EXACT error message,\n\
+* your version of the program,\n\
+* the computer system you are running it on,\n\
+* command line and configuration file options,\n\
+* input (if possible),\n\
+\n\
+Thank you!\n";
+
+	try {
+		std::string input_name, rigid_name, flex_name, out_name;
+		int cpu = 0;
+		bool help = false, version = false;
+		options_description inputs("Input - either a ligand library or a receptor");
+		inputs.add_options()
+			("input", value<std::string>(&input_name), "ligand library to precompile (multi-MODEL PDBQT, possibly compressed)")
+			("receptor", value<std::string>(&rigid_name), "rigid part of the receptor to save a snapshot of (PDBQT)")
+			("flex", value<std::string>(&flex_name), "flexible side chains of the receptor, if any (PDBQT)")
+		;
+		options_description outputs("Output (optional) - the default is chosen based on the input file name");
+		outputs.add_options()
+			("out", value<std::string>(&out_name), "precompiled library, for vina --ligand_library, or receptor snapshot, for vina --receptor")
+		;
+		options_description misc("Misc (optional)");
+		misc.add_options()
+			("cpu", value<int>(&cpu), "the number of CPUs to use for bonding the receptor (the default is to try to detect the number of CPUs or, failing that, use 1)")
+		;
+		options_description info("Information (optional)");
+		info.add_options()
+			("help", bool_switch(&help), "print this message")
+			("version", bool_switch(&version), "print program version")
+		;
+		options_description desc;
+		desc.add(inputs).add(outputs).add(misc).add(info);
+
+		positional_options_description positional; // remains empty
+		variables_map vm;
+		try {
+			store(command_line_parser(argc, argv)
+				.options(desc)
+				.style(command_line_style::default_style ^ command_line_style::allow_guessing)
+				.positional(positional)
+				.run(), 
+				vm);
+			notify(vm); 
+		}
+		catch(boost::program_options::error& e) {
+			std::cerr << "Command line parse error: " << e.what() << '\n' << "\nCorrect usage:\n" << desc << '\n';
+			return 1;
+		}
+		if(help) {
+			std::cout << desc << '\n';
+			return 0;
+		}
+		if(version) {
+			std::cout << version_string << '\n';
+			return 0;
+		}
+
+		if(vm.count("input") <= 0 && vm.count("receptor") <= 0) {
+			std::cerr << "Missing input.\n" << "\nCorrect usage:\n" << desc << '\n';
+			return 1;
+		}
+		if(vm.count("input") > 0 && vm.count("receptor") > 0)
+			throw usage_error("Use either input or receptor, not both");
+		if(vm.count("flex") > 0 && vm.count("receptor") <= 0)
+			throw usage_error("Flexible side chains are not allowed without the rest of the receptor");
+		const bool receptor = vm.count("receptor") > 0;
+		if(vm.count("out") <= 0) {
+			out_name = receptor ? default_output(rigid_name, ".vrec") : default_output(input_name, ".vlib");
+			std::cout << "Output will be " << out_name << '\n';
+		}
+		if(make_path(out_name) == make_path(receptor ? rigid_name : input_name) || (vm.count("flex") > 0 && make_path(out_name) == make_path(flex_name)))
+			throw usage_error("The output would overwrite the input");
+
+		if(receptor) {
+			if(vm.count("cpu") == 0)
+				cpu = boost::thread::hardware_concurrency();
+			const sz num_threads = (cpu > 0) ? sz(cpu) : 1;
+			const model m = (vm.count("flex") > 0) ? parse_receptor_pdbqt(make_path(rigid_name), make_path(flex_name), num_threads)
+			                                       : parse_receptor_pdbqt(make_path(rigid_name), num_threads);
+			write_receptor_snapshot(make_path(out_name), m);
+			std::cout << "Saved a snapshot of the receptor\n";
+			return 0;
+		}
+
+		ligand_library ligands(make_path(input_name), 0, 1);
+		ligand_archive_writer archive(make_path(out_name));
+		sz count = 0;
+		while(ligands.next()) {
+			++count;
+			try {
+				archive.add(ligands.parse());
+			}
+			catch(parse_error& e) { // the same policy as vina --ligand_library
+				std::cerr << "WARNING: skipping ligand " << count << ". Parse error on line " << e.line << ": " << e.reason << '\n';
+			}
+		}
+		archive.finish();
+		std::cout << "Precompiled " << archive.size() << " of " << count << " ligands\n";
+	}
+	catch(file_error& e) {
+		std::cerr << "\n\nError: could not open \"" << e.name.filename() << "\" for " << (e.in ? "reading" : "writing") << ".\n";
+		return 1;
+	}
+	catch(boost::filesystem::filesystem_error& e) {
+		std::cerr << "\n\nFile system error: " << e.what() << '\n';
+		return 1;
+	}
+	catch(usage_error& e) {
+		std::cerr << "\n\nUsage error: " << e.what() << ".\n";
+		return 1;
+	}
+	catch(parse_error& e) {
+		std::cerr << "\n\nParse error on line " << e.line << " in file \"" << e.file.filename() << "\": " << e.reason << '\n';
+		return 1;
+	}
+	catch(compression_error& e) {
+		std::cerr << "\n\nError reading \"" << e.name.filename() << "\": " << e.reason << ".\n";
+		return 1;
+	}
+	catch(archive_error& e) {
+		std::cerr << "\n\nError reading \"" << e.name.filename() << "\": " << e.reason << ".\n";
+		return 1;
+	}
+	catch(std::bad_alloc&) {
+		std::cerr << "\n\nError: insufficient memory!\n";
+		return 1;
+	}
+
+	// Errors that shouldn't happen:
+
+	catch(std::exception& e) { 
+		std::cerr << "\n\nAn error occurred: " << e.what() << ". " << error_message;
+		return 1; 
+	}
+	catch(internal_error& e) {
+		std::cerr << "\n\nAn internal error occurred in " << e.file << "(" << e.line << "). " << error_message;
+		return 1;
+	}
+	catch(...) {
+		std::cerr << "\n\nAn unknown error occurred. " << error_message;
+		return 1;
+	}
+}